@@ -2,11 +2,16 @@
 layout (location = 0) in vec4 vertex; // <vec2 pos, vec2 tex>
 out vec2 TexCoords;
 
-uniform mat4 projection;
-uniform mat4 viewMatrix;
+layout(std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+};
+
+uniform mat4 model = mat4(1.0);
 
 void main()
 {
-    gl_Position = projection * viewMatrix * vec4(vertex.xy, 0.0, 1.0);
+    gl_Position = projection * view * model * vec4(vertex.xy, 0.0, 1.0);
     TexCoords = vertex.zw;
-}
\ No newline at end of file
+}
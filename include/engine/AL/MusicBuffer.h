@@ -1,6 +1,6 @@
 #pragma once
 #include <AL/al.h>
-#include <sndfile.h>
+#include <engine/AL/SoundFile.h>
 
 
 class MusicBuffer
@@ -27,6 +27,8 @@ private:
 	ALuint p_Buffers[NUM_BUFFERS];
 	SNDFILE* p_SndFile;
 	SF_INFO p_Sfinfo;
+	//Read position when streaming from an asset pack
+	MemorySoundFile p_Memory;
 	short* p_Membuf;
 	ALenum p_Format;
 
@@ -16,4 +16,23 @@ private:
 	~SoundBuffer();
 
 	std::vector<ALuint> p_SoundEffectBuffers;
-};
\ No newline at end of file
+};
+//A sound effect buffer that is removed from the SoundBuffer when destroyed, so it can be shared through the AssetManager
+//AssetManager::Get()->Load<SoundEffect>("assets/jump.wav")->buffer
+struct SoundEffect
+{
+	SoundEffect(const char* filename)
+	{
+		buffer = SoundBuffer::getFile()->addSoundEffect(filename);
+	}
+	~SoundEffect()
+	{
+		if (buffer)
+			SoundBuffer::getFile()->removeSoundEffect(buffer);
+	}
+
+	SoundEffect(const SoundEffect&) = delete;
+	SoundEffect& operator=(const SoundEffect&) = delete;
+
+	ALuint buffer = 0;
+};
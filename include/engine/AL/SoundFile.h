@@ -0,0 +1,67 @@
+#pragma once
+#include <sndfile.h>
+#include <cstring>
+#include <engine/FileSystem.h>
+
+//A sound file being read from a mounted asset pack, must stay alive until the SNDFILE is closed
+struct MemorySoundFile
+{
+	engine::FileView file;
+	sf_count_t position = 0;
+};
+
+//libsndfile callbacks reading from a MemorySoundFile
+inline SF_VIRTUAL_IO* MemorySoundFileIO()
+{
+	static SF_VIRTUAL_IO io = {
+		[](void* data) -> sf_count_t
+		{
+			return (sf_count_t)((MemorySoundFile*)data)->file.size;
+		},
+		[](sf_count_t offset, int whence, void* data) -> sf_count_t
+		{
+			MemorySoundFile* memory = (MemorySoundFile*)data;
+			sf_count_t position = offset;
+			if (whence == SEEK_CUR)
+				position += memory->position;
+			else if (whence == SEEK_END)
+				position += (sf_count_t)memory->file.size;
+
+			if (position < 0 || position > (sf_count_t)memory->file.size)
+				return -1;
+			memory->position = position;
+			return position;
+		},
+		[](void* buffer, sf_count_t count, void* data) -> sf_count_t
+		{
+			MemorySoundFile* memory = (MemorySoundFile*)data;
+			sf_count_t left = (sf_count_t)memory->file.size - memory->position;
+			if (count > left)
+				count = left;
+			std::memcpy(buffer, memory->file.data + memory->position, (size_t)count);
+			memory->position += count;
+			return count;
+		},
+		[](const void*, sf_count_t, void*) -> sf_count_t
+		{
+			//Packs are read only
+			return 0;
+		},
+		[](void* data) -> sf_count_t
+		{
+			return ((MemorySoundFile*)data)->position;
+		}
+	};
+	return &io;
+}
+
+//Open a sound file for reading, from a mounted asset pack if it has it, otherwise from disk
+//memory holds the read position in the pack and must outlive the returned SNDFILE
+inline SNDFILE* OpenSoundFile(const char* filename, SF_INFO* info, MemorySoundFile& memory)
+{
+	memory.file = engine::FileSystem::Get()->Find(filename);
+	memory.position = 0;
+	if (memory.file)
+		return sf_open_virtual(MemorySoundFileIO(), SFM_READ, info, &memory);
+	return sf_open(filename, SFM_READ, info);
+}
@@ -12,7 +12,10 @@
 
 //Other engine libs
 #include <engine/GL/Window.h>
+#include <engine/GL/TextureLoader.h>
 #include <engine/Image.h>
+#include <engine/TextureAtlas.h>
+#include <engine/AssetManager.h>
 #include <engine/AL/SoundDevice.h>
 #include <engine/AL/SoundSource.h>
 #include <engine/AL/SoundBuffer.h>
@@ -51,6 +54,7 @@ namespace engine
 			ecs.registerComponent<SpriteRenderer>();
 			ecs.registerComponent<ModelRenderer>();
 			ecs.registerComponent<Transform>();
+			ecs.registerComponent<Hierarchy>();
 			ecs.registerComponent<Animator>();
 			ecs.registerComponent<Rigidbody>();
 			ecs.registerComponent<BoxCollider>();
@@ -113,13 +117,23 @@ namespace engine
 		//Updates all default engine systems, calculates and returns delta time
 		double Update(Camera* cam)
 		{
+			//Start counting this frame's render state changes
+			RenderState::Get()->NewFrame();
+			//Upload textures that finished loading in the background
+			TextureLoader::Get()->Update();
+			//Keep texture memory under budget
+			TextureMemory::Get()->Update();
+
 			//Update engine systems
-			transformSystem->Update();
 			physicsSystem->Update(deltaTime);
 			collisionSystem->Update();
 			animationSystem->Update(deltaTime);
+			//Rebuild the model matrices of everything that moved, right before rendering
+			transformSystem->Update();
 			spriteRenderSystem->Update(cam);
 			modelRenderSystem->Update(cam);
+			//Debug shapes go over the world but under the UI
+			DebugDraw::Get()->Flush(cam);
 			uiSystem->Update(cam);
 
 			//Calculate Delta Time
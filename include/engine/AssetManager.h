@@ -0,0 +1,208 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <typeinfo>
+#include <type_traits>
+#include <filesystem>
+#include <iostream>
+#include <cstdint>
+#include <cassert>
+
+namespace engine
+{
+	//Bookkeeping for one loaded asset, shared by every handle to it
+	struct AssetEntry
+	{
+		void* asset = nullptr;
+		const std::type_info* type = nullptr;
+		std::string path;
+		uint64_t key = 0;
+		unsigned int references = 0;
+		void (*destroy)(void*) = nullptr;
+	};
+
+	//A reference counted handle to an asset loaded by the AssetManager
+	//Copying a handle adds a reference and destroying one removes it, the asset stays loaded while any handle to it exists
+	//Handles convert to a plain pointer, so they can be given straight to components such as SpriteRenderer
+	//Keep a handle for as long as the pointer is in use, references are not thread safe
+	template<typename T>
+	class AssetHandle
+	{
+	public:
+		AssetHandle() {}
+		AssetHandle(const AssetHandle& other) : AssetHandle(other.entry) {}
+		AssetHandle(AssetHandle&& other) noexcept : entry(other.entry)
+		{
+			other.entry = nullptr;
+		}
+		~AssetHandle()
+		{
+			Reset();
+		}
+
+		AssetHandle& operator=(AssetHandle other) noexcept
+		{
+			std::swap(entry, other.entry);
+			return *this;
+		}
+
+		//Drop this handle's reference
+		void Reset()
+		{
+			if (entry)
+				entry->references--;
+			entry = nullptr;
+		}
+
+		T* Get() const
+		{
+			return entry ? (T*)entry->asset : nullptr;
+		}
+		T* operator->() const
+		{
+			return Get();
+		}
+		T& operator*() const
+		{
+			return *Get();
+		}
+		operator T*() const
+		{
+			return Get();
+		}
+
+		//The normalized path the asset was loaded from
+		const std::string& Path() const
+		{
+			static const std::string none;
+			return entry ? entry->path : none;
+		}
+
+	private:
+		friend class AssetManager;
+
+		explicit AssetHandle(AssetEntry* entry) : entry(entry)
+		{
+			if (entry)
+				entry->references++;
+		}
+
+		AssetEntry* entry = nullptr;
+	};
+
+	//Loads every asset only once for the whole game
+	//Assets are found by a hash of their type, normalized path and load arguments, so "assets/./a.png" and "assets/a.png" are the same texture
+	//Assets without references are kept until Collect is called, so reloading a level doesn't load them again
+	class AssetManager
+	{
+	public:
+		static AssetManager* Get()
+		{
+			static AssetManager* manager = new AssetManager();
+			return manager;
+		}
+
+		//Load a T constructed from the path and args, or get the already loaded one
+		//For example Load<Texture>("assets/bullet.png") or Load<Texture>("assets/rock.png", GL_LINEAR)
+		template<typename T, typename... Args>
+		AssetHandle<T> Load(const std::string& path, const Args&... args)
+		{
+			std::string normalized = Normalize(path);
+
+			uint64_t key = HashBytes(FNV_OFFSET, normalized.data(), normalized.size());
+			key = HashBytes(key, typeid(T).name(), std::char_traits<char>::length(typeid(T).name()));
+			(HashArgument(key, args), ...);
+
+			//Assets whose key happens to collide are stored under the same key, find the one with this path and type
+			auto [first, last] = entries.equal_range(key);
+			for (auto it = first; it != last; it++)
+			{
+				if (it->second->path == normalized && *it->second->type == typeid(T))
+					return AssetHandle<T>(it->second);
+			}
+
+			AssetEntry* entry = new AssetEntry();
+			entry->asset = new T(normalized.c_str(), args...);
+			entry->type = &typeid(T);
+			entry->path = normalized;
+			entry->key = key;
+			entry->destroy = [](void* asset) { delete (T*)asset; };
+			entries.emplace(key, entry);
+			return AssetHandle<T>(entry);
+		}
+
+		//Unload every asset no handle refers to anymore, returns how many were unloaded
+		size_t Collect()
+		{
+			size_t unloaded = 0;
+			for (auto it = entries.begin(); it != entries.end();)
+			{
+				if (it->second->references == 0)
+				{
+					it->second->destroy(it->second->asset);
+					delete it->second;
+					it = entries.erase(it);
+					unloaded++;
+				}
+				else
+				{
+					it++;
+				}
+			}
+			return unloaded;
+		}
+
+		//How many assets are loaded, including unreferenced ones waiting for Collect
+		size_t Count() const
+		{
+			return entries.size();
+		}
+
+		//Print every loaded asset and its reference count
+		void PrintAssets() const
+		{
+			for (const auto& [key, entry] : entries)
+				std::cout << entry->path << ": " << entry->references << " references" << std::endl;
+		}
+
+	private:
+		AssetManager() {}
+
+		static const uint64_t FNV_OFFSET = 14695981039346656037ull;
+
+		static std::string Normalize(const std::string& path)
+		{
+			return std::filesystem::path(path).lexically_normal().generic_string();
+		}
+
+		//FNV-1a
+		static uint64_t HashBytes(uint64_t hash, const void* data, size_t size)
+		{
+			const unsigned char* bytes = (const unsigned char*)data;
+			for (size_t i = 0; i < size; i++)
+			{
+				hash ^= bytes[i];
+				hash *= 1099511628211ull;
+			}
+			return hash;
+		}
+
+		//Load arguments are part of the key, a texture loaded with different filtering is a different asset
+		template<typename A>
+		static void HashArgument(uint64_t& hash, const A& argument)
+		{
+			if constexpr (std::is_convertible_v<A, std::string>)
+			{
+				std::string string = argument;
+				hash = HashBytes(hash, string.data(), string.size());
+			}
+			else
+			{
+				static_assert(std::is_trivially_copyable_v<A>, "Asset load arguments must be strings or plain values");
+				hash = HashBytes(hash, &argument, sizeof(A));
+			}
+		}
+
+		std::unordered_multimap<uint64_t, AssetEntry*> entries;
+	};
+}
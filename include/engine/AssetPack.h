@@ -0,0 +1,243 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iterator>
+#include <filesystem>
+#include <algorithm>
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <engine/MappedFile.h>
+
+namespace engine
+{
+	//A read only view of a file's bytes
+	struct FileView
+	{
+		const unsigned char* data = nullptr;
+		size_t size = 0;
+
+		explicit operator bool() const
+		{
+			return data != nullptr;
+		}
+	};
+
+	//Many asset files packed into one, made by the AssetPacker tool and read through a memory mapping
+	//Layout: header, the files aligned to 16 bytes, the index of entries sorted by path hash, then the paths
+	//Files are found by a hash of their normalized path, so a lookup is a binary search and no file is opened
+	class AssetPack
+	{
+	public:
+		static const uint32_t VERSION = 1;
+		static const uint32_t ALIGNMENT = 16;
+
+		//How an entry is stored. Only uncompressed entries exist for now, the field is there so compression can be added without changing the layout
+		enum class Codec : uint32_t
+		{
+			none = 0
+		};
+
+		struct Header
+		{
+			char magic[4];
+			uint32_t version;
+			uint32_t entryCount;
+			uint32_t reserved;
+			uint64_t indexOffset;
+			uint64_t stringsOffset;
+			uint64_t stringsSize;
+		};
+
+		struct Entry
+		{
+			uint64_t pathHash;
+			uint64_t offset;
+			//Size of the file when read
+			uint64_t size;
+			//Size of the data in the pack, the same as size unless compressed
+			uint64_t storedSize;
+			uint32_t pathOffset;
+			uint32_t pathLength;
+			uint32_t codec;
+			uint32_t reserved;
+		};
+
+		//Normalize a path the same way when packing and when looking up, "./assets/a.png" and "assets\a.png" become "assets/a.png"
+		static std::string NormalizePath(const std::string& path)
+		{
+			std::string normalized = std::filesystem::path(path).lexically_normal().generic_string();
+			std::replace(normalized.begin(), normalized.end(), '\\', '/');
+			return normalized;
+		}
+
+		//FNV-1a of the normalized path
+		static uint64_t HashPath(const std::string& normalizedPath)
+		{
+			uint64_t hash = 14695981039346656037ull;
+			for (unsigned char c : normalizedPath)
+			{
+				hash ^= c;
+				hash *= 1099511628211ull;
+			}
+			return hash;
+		}
+
+		//Pack files into a new pack at packPath, each is stored under its path as given. Returns false if anything can't be read or written
+		static bool Write(const std::string& packPath, const std::vector<std::string>& files)
+		{
+			std::ofstream pack(packPath, std::ios::binary);
+			if (!pack)
+				return false;
+
+			Header header = {};
+			std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+			header.version = VERSION;
+			header.entryCount = files.size();
+			pack.write((const char*)&header, sizeof(header));
+
+			std::vector<Entry> entries;
+			std::string strings;
+			for (const std::string& path : files)
+			{
+				std::ifstream file(path, std::ios::binary);
+				if (!file)
+				{
+					std::cout << "Error reading " << path << std::endl;
+					return false;
+				}
+				std::vector<char> contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+				Pad(pack, Align(pack.tellp()));
+
+				std::string normalized = NormalizePath(path);
+				Entry entry = {};
+				entry.pathHash = HashPath(normalized);
+				entry.offset = pack.tellp();
+				entry.size = contents.size();
+				entry.storedSize = contents.size();
+				entry.pathOffset = strings.size();
+				entry.pathLength = normalized.size();
+				entry.codec = (uint32_t)Codec::none;
+				entries.push_back(entry);
+				strings += normalized;
+
+				pack.write(contents.data(), contents.size());
+			}
+
+			std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.pathHash < b.pathHash; });
+
+			Pad(pack, Align(pack.tellp()));
+			header.indexOffset = pack.tellp();
+			pack.write((const char*)entries.data(), entries.size() * sizeof(Entry));
+			header.stringsOffset = pack.tellp();
+			header.stringsSize = strings.size();
+			pack.write(strings.data(), strings.size());
+
+			pack.seekp(0);
+			pack.write((const char*)&header, sizeof(header));
+			return (bool)pack;
+		}
+
+		//Map the pack at path and check that everything in it is within the file
+		bool Open(const std::string& path)
+		{
+			if (!file.Open(path))
+			{
+				std::cout << "Error opening asset pack " << path << std::endl;
+				return false;
+			}
+			if (!Validate())
+			{
+				std::cout << "Error loading asset pack " << path << ", the file is corrupt or from a different version. Pack it again" << std::endl;
+				file.Close();
+				return false;
+			}
+			return true;
+		}
+
+		//Find the file stored under path, the view is empty if the pack doesn't have it
+		FileView Find(const std::string& path) const
+		{
+			if (!file.IsOpen())
+				return FileView();
+
+			std::string normalized = NormalizePath(path);
+			uint64_t hash = HashPath(normalized);
+
+			const Entry* begin = GetEntries();
+			const Entry* end = begin + GetHeader().entryCount;
+			const Entry* entry = std::lower_bound(begin, end, hash, [](const Entry& e, uint64_t h) { return e.pathHash < h; });
+
+			//Paths with the same hash are next to each other
+			for (; entry != end && entry->pathHash == hash; entry++)
+			{
+				if (entry->pathLength == normalized.size() && std::memcmp(GetStrings() + entry->pathOffset, normalized.data(), normalized.size()) == 0)
+					return FileView{ file.Data() + entry->offset, (size_t)entry->size };
+			}
+			return FileView();
+		}
+
+		size_t EntryCount() const
+		{
+			return file.IsOpen() ? GetHeader().entryCount : 0;
+		}
+
+	private:
+		static constexpr char MAGIC[4] = { 'E', 'P', 'A', 'K' };
+
+		const Header& GetHeader() const
+		{
+			return *(const Header*)file.Data();
+		}
+		const Entry* GetEntries() const
+		{
+			return (const Entry*)(file.Data() + GetHeader().indexOffset);
+		}
+		const char* GetStrings() const
+		{
+			return (const char*)file.Data() + GetHeader().stringsOffset;
+		}
+
+		//Make sure every offset points inside the file so a bad pack can't make us read out of bounds
+		bool Validate() const
+		{
+			uint64_t size = file.Size();
+			if (size < sizeof(Header))
+				return false;
+
+			const Header& header = GetHeader();
+			if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION)
+				return false;
+			if (header.indexOffset % ALIGNMENT || header.indexOffset + (uint64_t)header.entryCount * sizeof(Entry) > size)
+				return false;
+			if (header.stringsOffset + header.stringsSize > size)
+				return false;
+
+			for (uint32_t i = 0; i < header.entryCount; i++)
+			{
+				const Entry& entry = GetEntries()[i];
+				if (entry.offset + entry.storedSize > size || (uint64_t)entry.pathOffset + entry.pathLength > header.stringsSize)
+					return false;
+				if (entry.codec != (uint32_t)Codec::none || entry.storedSize != entry.size)
+					return false;
+			}
+			return true;
+		}
+
+		static uint64_t Align(uint64_t offset)
+		{
+			return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+		}
+
+		//Write zeros until the file is at offset
+		static void Pad(std::ofstream& file, uint64_t offset)
+		{
+			while ((uint64_t)file.tellp() < offset)
+				file.put(0);
+		}
+
+		MappedFile file;
+	};
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace engine
+{
+	//A fixed size lock-free queue any number of threads can push to and pop from at once
+	//Dmitry Vyukov's bounded MPMC queue: each cell has a sequence number telling whether it is ready to be written or read,
+	//so threads only contend on the head and tail counters and never block each other
+	template<typename T>
+	class BoundedQueue
+	{
+	public:
+		//capacity is rounded up to a power of two
+		BoundedQueue(size_t capacity = 64)
+		{
+			size_t size = 2;
+			while (size < capacity)
+				size *= 2;
+
+			cells = std::vector<Cell>(size);
+			mask = size - 1;
+			for (size_t i = 0; i < size; i++)
+				cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+
+		BoundedQueue(const BoundedQueue&) = delete;
+		BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+		//Returns false if the queue is full, value is then left untouched
+		bool TryPush(T&& value)
+		{
+			size_t position = tail.load(std::memory_order_relaxed);
+			Cell* cell;
+			while (true)
+			{
+				cell = &cells[position & mask];
+				size_t sequence = cell->sequence.load(std::memory_order_acquire);
+				intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+
+				//The cell is free, try to claim it
+				if (difference == 0)
+				{
+					if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+						break;
+				}
+				//The cell still holds a value from one lap ago
+				else if (difference < 0)
+					return false;
+				//Another thread claimed it first
+				else
+					position = tail.load(std::memory_order_relaxed);
+			}
+
+			cell->value = std::move(value);
+			cell->sequence.store(position + 1, std::memory_order_release);
+			return true;
+		}
+
+		//Returns false if the queue is empty
+		bool TryPop(T& value)
+		{
+			size_t position = head.load(std::memory_order_relaxed);
+			Cell* cell;
+			while (true)
+			{
+				cell = &cells[position & mask];
+				size_t sequence = cell->sequence.load(std::memory_order_acquire);
+				intptr_t difference = (intptr_t)sequence - (intptr_t)(position + 1);
+
+				if (difference == 0)
+				{
+					if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+						break;
+				}
+				else if (difference < 0)
+					return false;
+				else
+					position = head.load(std::memory_order_relaxed);
+			}
+
+			value = std::move(cell->value);
+			//Mark the cell free for the push one lap from now
+			cell->sequence.store(position + mask + 1, std::memory_order_release);
+			return true;
+		}
+
+	private:
+		struct Cell
+		{
+			std::atomic<size_t> sequence;
+			T value;
+
+			Cell() {}
+			Cell(const Cell&) : sequence(0) {}
+		};
+
+		std::vector<Cell> cells;
+		size_t mask = 0;
+		//Kept on separate cache lines so pushing and popping threads don't slow each other down
+		alignas(64) std::atomic<size_t> head{ 0 };
+		alignas(64) std::atomic<size_t> tail{ 0 };
+	};
+}
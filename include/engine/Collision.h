@@ -1,6 +1,7 @@
 #pragma once
 #include <engine/Vector.h>
 #include <engine/ECSCore.h>
+#include <engine/GL/DebugDraw.h>
 #include <vector>
 #include <array>
 
@@ -19,7 +20,7 @@ namespace engine
 		//This is updated automatically and is set in world coordinates
 		std::array<float, 4> bounds;
 
-		//Draw the collider vertices
+		//Draw the collider with DebugDraw every frame
 		bool visualize = false;
 	};
 
@@ -46,7 +47,41 @@ namespace engine
 			//For each entity
 			for (const Entity& entity : entities)
 			{
+				PolygonCollider& collider = ecs.getComponent<PolygonCollider>(entity);
+				if (collider.visualize)
+				{
+					WorldVertices(entity, scratchVertices);
+					DebugDraw::Get()->Polygon(scratchVertices, visualizeColor);
+				}
+			}
+		}
 
+		//The vertices of entity's collider rotated, scaled and moved by its transform
+		vector<Vector2> WorldVertices(Entity entity)
+		{
+			vector<Vector2> vertices;
+			WorldVertices(entity, vertices);
+			return vertices;
+		}
+		//Write the transformed vertices into vertices, replacing what was in it. Reusing one vector doesn't allocate every call
+		void WorldVertices(Entity entity, vector<Vector2>& vertices)
+		{
+			Transform& transform = ecs.getComponent<Transform>(entity);
+			PolygonCollider& collider = ecs.getComponent<PolygonCollider>(entity);
+
+			vertices.clear();
+			float angle = transform.rotation.z * PI / 180;
+			for (size_t i = 0; i < collider.vertices.size(); i++)
+			{
+				Vector2 transformedVert;
+				//Rotate
+				transformedVert.x = collider.vertices[i].x * cos(angle) - collider.vertices[i].y * sin(angle);
+				transformedVert.y = collider.vertices[i].x * sin(angle) + collider.vertices[i].y * cos(angle);
+				//Scale
+				transformedVert *= Vector2(transform.scale);
+				//Move
+				transformedVert += transform.position;
+				vertices.push_back(transformedVert);
 			}
 		}
 
@@ -173,26 +208,14 @@ namespace engine
 		//Update the AABB of the polygon collider
 		void UpdateAABB(Entity entity)
 		{
-			Transform& transform = ecs.getComponent<Transform>(entity);
 			PolygonCollider& collider = ecs.getComponent<PolygonCollider>(entity);
 
 			//Bounds go top, right, bottom, left
 			std::array<float, 4> bounds{ -INFINITY, -INFINITY, INFINITY, INFINITY };
-			//For each vertice apply the tranform and calculate min and max bounds
-			for (int i = 0; i < collider.vertices.size(); i++)
+			//Calculate min and max bounds of the transformed vertices
+			WorldVertices(entity, scratchVertices);
+			for (const Vector2& transformedVert : scratchVertices)
 			{
-				//Apply transform to the polygon collider
-				Vector2 transformedVert = collider.vertices[i];
-				//Rotate
-				float angle = transform.rotation.z * PI / 180;
-				transformedVert.x = collider.vertices[i].x * cos(angle) - collider.vertices[i].y * sin(angle);
-				transformedVert.y = collider.vertices[i].x * sin(angle) + collider.vertices[i].y * cos(angle);
-				//Scale
-				transformedVert *= Vector2(transform.scale);
-				//Move
-				transformedVert += transform.position;
-
-				//Check bounds
 				//Top bound
 				if (transformedVert.y > bounds[0])
 					bounds[0] = transformedVert.y;
@@ -209,5 +232,12 @@ namespace engine
 
 			collider.bounds = bounds;
 		}
+
+		//Color of colliders with visualize set
+		Vector3 visualizeColor = Vector3(0, 255, 0);
+
+	private:
+		//Reused by UpdateAABB and visualizing so transforming a collider doesn't allocate
+		vector<Vector2> scratchVertices;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,335 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <engine/GL/Mesh.h>
+#include <engine/GL/Frustum.h>
+#include <engine/MappedFile.h>
+#include <engine/FileSystem.h>
+#include <engine/ModelData.h>
+
+namespace engine
+{
+	//The binary model format made by the model cooker tool
+	//A cooked model is memory mapped and its vertex and index data uploaded straight from the mapped pages, without any parsing
+	//Layout: Header, MeshRecord * meshCount, TextureRecord * textureCount, string data, then the vertex and index data of each mesh
+	class CookedModel
+	{
+	public:
+		//Increment whenever the layout changes, older files are then rejected and need to be cooked again
+		static const uint32_t VERSION = 2;
+		//Every data blob starts at a multiple of this
+		static const uint32_t ALIGNMENT = 16;
+
+		struct Header
+		{
+			char magic[4];
+			uint32_t version;
+			uint32_t meshCount;
+			uint32_t textureCount;
+			uint64_t stringsOffset;
+			uint64_t stringsSize;
+			float boundsMin[3];
+			float boundsMax[3];
+		};
+
+		struct MeshRecord
+		{
+			uint64_t vertexOffset;
+			uint64_t indexOffset;
+			uint32_t vertexCount;
+			uint32_t indexCount;
+			//Bytes per vertex and per index, checked against what the engine expects when loading
+			uint32_t vertexStride;
+			uint32_t indexSize;
+			uint32_t firstTexture;
+			uint32_t textureCount;
+			float boundsMin[3];
+			float boundsMax[3];
+			//Mesh::VertexFormat
+			uint32_t vertexFormat;
+			uint32_t reserved;
+		};
+
+		//Offsets into the string data
+		struct TextureRecord
+		{
+			uint32_t typeOffset;
+			uint32_t typeLength;
+			uint32_t pathOffset;
+			uint32_t pathLength;
+		};
+
+		//A mesh inside the mapped file, the pointers are valid as long as the CookedModel is open
+		struct MeshView
+		{
+			const void* vertices;
+			uint32_t vertexCount;
+			Mesh::VertexFormat vertexFormat;
+			const void* indices;
+			uint32_t indexCount;
+			//GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+			unsigned int indexType;
+			std::vector<MaterialTexture> textures;
+			AABB bounds;
+		};
+
+		//Returns true if the file at path starts like a cooked model
+		static bool IsCooked(const std::string& path)
+		{
+			FileView packed = FileSystem::Get()->Find(path);
+			if (packed)
+				return packed.size >= sizeof(MAGIC) && std::memcmp(packed.data, MAGIC, sizeof(MAGIC)) == 0;
+
+			std::ifstream file(path, std::ios::binary);
+			char magic[4] = {};
+			file.read(magic, sizeof(magic));
+			return file && std::memcmp(magic, MAGIC, sizeof(magic)) == 0;
+		}
+
+		//Write model to path in the cooked format, returns false if the file can't be written
+		static bool Write(const ModelData& model, const std::string& path)
+		{
+			Header header = {};
+			std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+			header.version = VERSION;
+			header.meshCount = model.meshes.size();
+			StoreBounds(model.bounds, header.boundsMin, header.boundsMax);
+
+			std::vector<MeshRecord> meshRecords;
+			std::vector<TextureRecord> textureRecords;
+			std::string strings;
+			for (const MeshData& mesh : model.meshes)
+			{
+				MeshRecord record = {};
+				record.vertexCount = mesh.vertices.size();
+				record.indexCount = mesh.indices.size();
+				record.vertexFormat = (uint32_t)mesh.vertexFormat;
+				record.vertexStride = Mesh::VertexSize(mesh.vertexFormat);
+				record.indexSize = Mesh::IndexSize(Mesh::IndexTypeFor(mesh.vertices.size()));
+				record.firstTexture = textureRecords.size();
+				record.textureCount = mesh.textures.size();
+				StoreBounds(mesh.bounds, record.boundsMin, record.boundsMax);
+				meshRecords.push_back(record);
+
+				for (const MaterialTexture& texture : mesh.textures)
+				{
+					TextureRecord textureRecord;
+					textureRecord.typeOffset = strings.size();
+					textureRecord.typeLength = texture.type.size();
+					strings += texture.type;
+					textureRecord.pathOffset = strings.size();
+					textureRecord.pathLength = texture.path.size();
+					strings += texture.path;
+					textureRecords.push_back(textureRecord);
+				}
+			}
+			header.textureCount = textureRecords.size();
+
+			//Lay out the data blobs after the tables
+			uint64_t offset = sizeof(Header) + meshRecords.size() * sizeof(MeshRecord) + textureRecords.size() * sizeof(TextureRecord);
+			header.stringsOffset = offset;
+			header.stringsSize = strings.size();
+			offset += strings.size();
+			for (size_t i = 0; i < meshRecords.size(); i++)
+			{
+				offset = Align(offset);
+				meshRecords[i].vertexOffset = offset;
+				offset += (uint64_t)meshRecords[i].vertexCount * meshRecords[i].vertexStride;
+				offset = Align(offset);
+				meshRecords[i].indexOffset = offset;
+				offset += (uint64_t)meshRecords[i].indexCount * meshRecords[i].indexSize;
+			}
+
+			std::ofstream file(path, std::ios::binary | std::ios::trunc);
+			if (!file)
+				return false;
+
+			file.write((const char*)&header, sizeof(header));
+			file.write((const char*)meshRecords.data(), meshRecords.size() * sizeof(MeshRecord));
+			file.write((const char*)textureRecords.data(), textureRecords.size() * sizeof(TextureRecord));
+			file.write(strings.data(), strings.size());
+			for (size_t i = 0; i < model.meshes.size(); i++)
+			{
+				const MeshData& mesh = model.meshes[i];
+
+				//Store the data exactly as it will be uploaded
+				Pad(file, meshRecords[i].vertexOffset);
+				if (mesh.vertexFormat == Mesh::VertexFormat::packedNormals)
+				{
+					for (const Mesh::Vertex& vertex : mesh.vertices)
+					{
+						Mesh::PackedVertex packed{ vertex.Position, Mesh::PackNormal(vertex.Normal), vertex.TexCoords };
+						file.write((const char*)&packed, sizeof(packed));
+					}
+				}
+				else
+					file.write((const char*)mesh.vertices.data(), mesh.vertices.size() * sizeof(Mesh::Vertex));
+
+				Pad(file, meshRecords[i].indexOffset);
+				if (meshRecords[i].indexSize == sizeof(uint16_t))
+				{
+					std::vector<uint16_t> shortIndices(mesh.indices.begin(), mesh.indices.end());
+					file.write((const char*)shortIndices.data(), shortIndices.size() * sizeof(uint16_t));
+				}
+				else
+					file.write((const char*)mesh.indices.data(), mesh.indices.size() * sizeof(unsigned int));
+			}
+			return (bool)file;
+		}
+
+		//Map a cooked model, or find it in a mounted asset pack, and check that everything in it is within the file, returns false if it isn't valid
+		bool Open(const std::string& path)
+		{
+			FileView packed = FileSystem::Get()->Find(path);
+			if (packed)
+			{
+				data = packed.data;
+				size = packed.size;
+			}
+			else if (file.Open(path))
+			{
+				data = file.Data();
+				size = file.Size();
+			}
+			else
+			{
+				std::cout << "Error opening cooked model " << path << std::endl;
+				return false;
+			}
+
+			if (!Validate())
+			{
+				std::cout << "Error loading cooked model " << path << ", the file is corrupt or from a different version. Cook it again" << std::endl;
+				file.Close();
+				data = nullptr;
+				size = 0;
+				return false;
+			}
+			return true;
+		}
+
+		size_t MeshCount() const
+		{
+			return GetHeader().meshCount;
+		}
+
+		AABB Bounds() const
+		{
+			return LoadBounds(GetHeader().boundsMin, GetHeader().boundsMax);
+		}
+
+		MeshView GetMesh(size_t index) const
+		{
+			const MeshRecord& record = GetMeshRecords()[index];
+
+			MeshView mesh;
+			mesh.vertices = data + record.vertexOffset;
+			mesh.vertexCount = record.vertexCount;
+			mesh.vertexFormat = (Mesh::VertexFormat)record.vertexFormat;
+			mesh.indices = data + record.indexOffset;
+			mesh.indexCount = record.indexCount;
+			mesh.indexType = record.indexSize == sizeof(uint16_t) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+			mesh.bounds = LoadBounds(record.boundsMin, record.boundsMax);
+
+			const char* strings = (const char*)data + GetHeader().stringsOffset;
+			for (uint32_t i = 0; i < record.textureCount; i++)
+			{
+				const TextureRecord& texture = GetTextureRecords()[record.firstTexture + i];
+				mesh.textures.push_back(MaterialTexture{
+					std::string(strings + texture.typeOffset, texture.typeLength),
+					std::string(strings + texture.pathOffset, texture.pathLength) });
+			}
+			return mesh;
+		}
+
+	private:
+		static constexpr char MAGIC[4] = { 'E', 'M', 'D', 'L' };
+
+		const Header& GetHeader() const
+		{
+			return *(const Header*)data;
+		}
+		const MeshRecord* GetMeshRecords() const
+		{
+			return (const MeshRecord*)(data + sizeof(Header));
+		}
+		const TextureRecord* GetTextureRecords() const
+		{
+			return (const TextureRecord*)(GetMeshRecords() + GetHeader().meshCount);
+		}
+
+		//Make sure every offset and count points inside the file so a bad file can't make us read out of bounds
+		bool Validate() const
+		{
+			if (size < sizeof(Header))
+				return false;
+
+			const Header& header = GetHeader();
+			if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION)
+				return false;
+
+			uint64_t tablesEnd = sizeof(Header) + (uint64_t)header.meshCount * sizeof(MeshRecord) + (uint64_t)header.textureCount * sizeof(TextureRecord);
+			if (tablesEnd > size || header.stringsOffset < tablesEnd || header.stringsOffset + header.stringsSize > size)
+				return false;
+
+			for (uint32_t i = 0; i < header.meshCount; i++)
+			{
+				const MeshRecord& record = GetMeshRecords()[i];
+				if (record.vertexFormat > (uint32_t)Mesh::VertexFormat::packedNormals || record.vertexStride != Mesh::VertexSize((Mesh::VertexFormat)record.vertexFormat))
+					return false;
+				if (record.indexSize != sizeof(uint16_t) && record.indexSize != sizeof(uint32_t))
+					return false;
+				if (record.vertexOffset % ALIGNMENT || record.indexOffset % ALIGNMENT)
+					return false;
+				if (record.vertexOffset + (uint64_t)record.vertexCount * record.vertexStride > size)
+					return false;
+				if (record.indexOffset + (uint64_t)record.indexCount * record.indexSize > size)
+					return false;
+				if ((uint64_t)record.firstTexture + record.textureCount > header.textureCount)
+					return false;
+			}
+
+			for (uint32_t i = 0; i < header.textureCount; i++)
+			{
+				const TextureRecord& texture = GetTextureRecords()[i];
+				if ((uint64_t)texture.typeOffset + texture.typeLength > header.stringsSize || (uint64_t)texture.pathOffset + texture.pathLength > header.stringsSize)
+					return false;
+			}
+			return true;
+		}
+
+		static uint64_t Align(uint64_t offset)
+		{
+			return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+		}
+
+		//Write zeros until the file is at offset
+		static void Pad(std::ofstream& file, uint64_t offset)
+		{
+			while ((uint64_t)file.tellp() < offset)
+				file.put(0);
+		}
+
+		static void StoreBounds(const AABB& bounds, float* min, float* max)
+		{
+			for (int i = 0; i < 3; i++)
+			{
+				min[i] = bounds.min[i];
+				max[i] = bounds.max[i];
+			}
+		}
+		static AABB LoadBounds(const float* min, const float* max)
+		{
+			return AABB{ glm::vec3(min[0], min[1], min[2]), glm::vec3(max[0], max[1], max[2]) };
+		}
+
+		//Either the mapped file or part of an asset pack
+		const unsigned char* data = nullptr;
+		uint64_t size = 0;
+		MappedFile file;
+	};
+}
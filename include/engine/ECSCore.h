@@ -245,6 +245,11 @@ private:
 class System
 {
 public:
+	virtual ~System() {}
+
+	//Called when one of the system's entities is about to be destroyed, while its components still exist
+	virtual void OnEntityDestroyed(Entity) {}
+
 	//Set of every entity containing the required components for the system
 	std::set<Entity> entities;
 };
@@ -280,6 +285,16 @@ public:
 		systemSignatures.insert({ sytemType, signature });
 	}
 
+	//Let every system with the entity clean up after it before its components are removed
+	void entityDestroying(Entity entity)
+	{
+		for (auto const& system : systems)
+		{
+			if (system.second->entities.count(entity))
+				system.second->OnEntityDestroyed(entity);
+		}
+	}
+
 	void destroyEntity(Entity entity)
 	{
 		//Loop through each system and remove the destoyed entity
@@ -341,6 +356,7 @@ public:
 	//Destroys an entity and all of its components
 	void destroyEntity(Entity entity)
 	{
+		systemManager->entityDestroying(entity);
 		componentManager->destroyEntity(entity, entityManager->entitySignatures[entity]);
 		entityManager->deleteEntity(entity);
 		systemManager->destroyEntity(entity);
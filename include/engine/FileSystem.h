@@ -0,0 +1,54 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <engine/AssetPack.h>
+
+namespace engine
+{
+	//Finds asset files in mounted asset packs before falling back to loose files on disk
+	//Texture, Image, sound, music, tilemap and model loading all go through it, so mounting a pack is all a game needs to do
+	//Mount packs before loading anything, lookups happen on worker threads too
+	class FileSystem
+	{
+	public:
+		static FileSystem* Get()
+		{
+			static FileSystem* fileSystem = new FileSystem();
+			return fileSystem;
+		}
+
+		//Mount the asset pack at path, packs mounted later are searched first. Returns false if it can't be opened
+		bool Mount(const std::string& path)
+		{
+			std::unique_ptr<AssetPack> pack = std::make_unique<AssetPack>();
+			if (!pack->Open(path))
+				return false;
+			packs.insert(packs.begin(), std::move(pack));
+			return true;
+		}
+
+		//Unmount every pack. Views returned by Find become invalid
+		void UnmountAll()
+		{
+			packs.clear();
+		}
+
+		//Find path in the mounted packs, the view is empty if no pack has it and it should be read from disk
+		FileView Find(const std::string& path) const
+		{
+			for (const std::unique_ptr<AssetPack>& pack : packs)
+			{
+				FileView file = pack->Find(path);
+				if (file)
+					return file;
+			}
+			return FileView();
+		}
+
+	private:
+		FileSystem() {}
+
+		std::vector<std::unique_ptr<AssetPack>> packs;
+	};
+}
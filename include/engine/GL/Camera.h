@@ -1,6 +1,7 @@
 #pragma once
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <engine/GL/Frustum.h>
 
 namespace engine
 {
@@ -80,6 +81,12 @@ namespace engine
 			return model;
 		}
 
+		//Get the volume this camera can see, for skipping everything outside of it
+		Frustum GetFrustum()
+		{
+			return Frustum(GetProjectionMatrix() * GetViewMatrix());
+		}
+
 		glm::vec3 position;
 		glm::vec3 rotation;
 		bool perspective = false;
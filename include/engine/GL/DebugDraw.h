@@ -0,0 +1,270 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+#include <engine/Vector.h>
+#include <engine/GL/Shader.h>
+#include <engine/GL/Camera.h>
+#include <engine/GL/RenderState.h>
+#include <engine/GL/UniformBuffer.h>
+#include <engine/GL/Frustum.h>
+#include <engine/SpatialGrid.h>
+#include <engine/TextRender.h>
+
+namespace engine
+{
+	//Immediate mode drawing of lines, shapes and labels for debugging, such as colliders, contacts and culling grid cells
+	//Shapes are only drawn for the frame they are added in. Every shape goes into one streaming buffer,
+	//so a frame of debug drawing is two draw calls, lines and filled shapes, plus one for the labels
+	//Shapes are in world units and use the colors of PrimitiveRenderer, 0 to 255
+	class DebugDraw
+	{
+	public:
+		//Get the shared debug drawer. OpenGL must be initialized
+		static DebugDraw* Get()
+		{
+			static DebugDraw* debugDraw = new DebugDraw();
+			return debugDraw;
+		}
+
+		//Draw a line from a to b
+		void Line(Vector3 a, Vector3 b, Vector3 color = Vector3(255))
+		{
+			if (!enabled)
+				return;
+			Color packed = Pack(color, 1);
+			lines.push_back(Vertex{ a.x, a.y, a.z, packed });
+			lines.push_back(Vertex{ b.x, b.y, b.z, packed });
+		}
+		void Line(Vector2 a, Vector2 b, Vector3 color = Vector3(255))
+		{
+			Line(Vector3(a, z), Vector3(b, z), color);
+		}
+
+		//Draw a rectangle from its bottom left corner to its top right corner
+		void Box(Vector2 min, Vector2 max, Vector3 color = Vector3(255), bool filled = false)
+		{
+			Polygon({ Vector2(min.x, min.y), Vector2(min.x, max.y), Vector2(max.x, max.y), Vector2(max.x, min.y) }, color, filled);
+		}
+		//Draw the outline of a bounding box, seen from the front
+		void Box(const AABB& bounds, Vector3 color = Vector3(255))
+		{
+			if (!bounds.Empty())
+				Box(Vector2(bounds.min.x, bounds.min.y), Vector2(bounds.max.x, bounds.max.y), color);
+		}
+
+		//Draw a polygon through vertices. Filled polygons must be convex
+		void Polygon(const std::vector<Vector2>& vertices, Vector3 color = Vector3(255), bool filled = false)
+		{
+			if (!enabled || vertices.size() < 2)
+				return;
+
+			if (filled && vertices.size() >= 3)
+			{
+				//A fan of triangles from the first vertex
+				Color packed = Pack(color, fillAlpha);
+				for (size_t i = 1; i + 1 < vertices.size(); i++)
+				{
+					triangles.push_back(Vertex{ vertices[0].x, vertices[0].y, z, packed });
+					triangles.push_back(Vertex{ vertices[i].x, vertices[i].y, z, packed });
+					triangles.push_back(Vertex{ vertices[i + 1].x, vertices[i + 1].y, z, packed });
+				}
+			}
+
+			//The outline is drawn on top of the fill
+			for (size_t i = 0; i < vertices.size(); i++)
+				Line(vertices[i], vertices[(i + 1) % vertices.size()], color);
+		}
+
+		//Draw a circle made of segments straight lines
+		void Circle(Vector2 center, float radius, Vector3 color = Vector3(255), bool filled = false, int segments = 24)
+		{
+			if (!enabled)
+				return;
+
+			circle.clear();
+			for (int i = 0; i < segments; i++)
+			{
+				float angle = 2 * (float)PI * i / segments;
+				circle.push_back(Vector2(center.x + std::cos(angle) * radius, center.y + std::sin(angle) * radius));
+			}
+			Polygon(circle, color, filled);
+		}
+
+		//Draw an X centered on point, for marking positions like contact points
+		void Cross(Vector2 point, float size, Vector3 color = Vector3(255))
+		{
+			float half = size / 2;
+			Line(Vector2(point.x - half, point.y - half), Vector2(point.x + half, point.y + half), color);
+			Line(Vector2(point.x - half, point.y + half), Vector2(point.x + half, point.y - half), color);
+		}
+
+		//Draw text with its pen starting at position. Labels need a font, see SetFont
+		//Every label of a frame is drawn in one color, labelColor
+		void Label(Vector2 position, std::string text)
+		{
+			if (enabled && font)
+				labels.push_back({ glm::vec2(position.x, position.y), std::move(text) });
+		}
+
+		//Set the font labels are drawn with, styleName is a style loaded into font
+		void SetFont(TextRender* font, std::string styleName, float scale = 0.5f)
+		{
+			this->font = font;
+			fontStyle = styleName;
+			labelScale = scale;
+		}
+
+		//Outline every cell of grid with something in it, with how many entities it holds if a font is set
+		void Grid(const SpatialGrid& grid, Vector3 color = Vector3(0, 160, 255))
+		{
+			if (!enabled)
+				return;
+
+			float size = grid.CellSize();
+			grid.ForEachCell([&](int x, int y, size_t count)
+				{
+					Box(Vector2(x * size, y * size), Vector2((x + 1) * size, (y + 1) * size), color);
+					Label(Vector2(x * size + 4, y * size + 4), std::to_string(count));
+				});
+		}
+
+		//Draw everything added since the last flush and start over. Called every frame by EngineLib::Update
+		void Flush(Camera* cam)
+		{
+			//Debug shapes are drawn over everything, then the depth test is put back how it was
+			bool depthTest = RenderState::Get()->IsEnabled(GL_DEPTH_TEST);
+			RenderState::Get()->Disable(GL_DEPTH_TEST);
+
+			if (!lines.empty() || !triangles.empty())
+			{
+				shader->use();
+				RenderState::Get()->Enable(GL_BLEND);
+				RenderState::Get()->BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+				CameraUniformBuffer* cameraBuffer = CameraUniformBuffer::Get();
+				cameraBuffer->Update(cam);
+				cameraBuffer->Use(shader);
+
+				//Fills first so the lines stay visible on top of them, both from one upload
+				//Orphan the buffer so the driver doesn't wait for last frame's draw
+				RenderState::Get()->BindVertexArray(VAO);
+				RenderState::Get()->BindBuffer(GL_ARRAY_BUFFER, VBO);
+				glBufferData(GL_ARRAY_BUFFER, (triangles.size() + lines.size()) * sizeof(Vertex), nullptr, GL_STREAM_DRAW);
+				glBufferSubData(GL_ARRAY_BUFFER, 0, triangles.size() * sizeof(Vertex), triangles.data());
+				glBufferSubData(GL_ARRAY_BUFFER, triangles.size() * sizeof(Vertex), lines.size() * sizeof(Vertex), lines.data());
+
+				if (!triangles.empty())
+					glDrawArrays(GL_TRIANGLES, 0, triangles.size());
+				if (!lines.empty())
+					glDrawArrays(GL_LINES, triangles.size(), lines.size());
+			}
+
+			if (font && !labels.empty())
+				font->RenderTexts(fontStyle, cam, labels, labelScale, labelColor.ToGlm() / 255.0f);
+
+			if (depthTest)
+				RenderState::Get()->Enable(GL_DEPTH_TEST);
+
+			//Clearing keeps the capacity, so after the first few frames nothing is allocated
+			lines.clear();
+			triangles.clear();
+			labels.clear();
+		}
+
+		//Lines and outlines added so far this frame
+		size_t LineCount() const
+		{
+			return lines.size() / 2;
+		}
+
+		//When false everything added is ignored, so debug drawing calls can be left in the game
+		bool enabled = true;
+		//Z of shapes given in 2D
+		float z = 0;
+		//Opacity of filled shapes, their outlines are opaque
+		float fillAlpha = 0.3f;
+		Vector3 labelColor = Vector3(255);
+
+	private:
+		struct Color
+		{
+			uint8_t r, g, b, a;
+		};
+
+		struct Vertex
+		{
+			float x, y, z;
+			Color color;
+		};
+
+		DebugDraw()
+		{
+			shader = new Shader(
+				R"(
+				#version 330 core
+				layout(location = 0) in vec3 aPos;
+				layout(location = 1) in vec4 aColor;
+
+				layout(std140) uniform Camera
+				{
+					mat4 view;
+					mat4 projection;
+				};
+
+				out vec4 vertexColor;
+
+				void main()
+				{
+					vertexColor = aColor;
+					gl_Position = projection * view * vec4(aPos, 1.0);
+				}
+				)",
+				R"(
+				#version 330 core
+				out vec4 FragColor;
+
+				in vec4 vertexColor;
+
+				void main()
+				{
+					FragColor = vertexColor;
+				}
+				)", false);
+
+			glGenVertexArrays(1, &VAO);
+			glGenBuffers(1, &VBO);
+			RenderState::Get()->BindVertexArray(VAO);
+			RenderState::Get()->BindBuffer(GL_ARRAY_BUFFER, VBO);
+
+			//Position, then color as normalized bytes
+			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+			glEnableVertexAttribArray(0);
+			glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (void*)offsetof(Vertex, color));
+			glEnableVertexAttribArray(1);
+
+			RenderState::Get()->BindVertexArray(0);
+		}
+
+		static Color Pack(Vector3 color, float alpha)
+		{
+			return Color{ (uint8_t)color.x, (uint8_t)color.y, (uint8_t)color.z, (uint8_t)(alpha * 255) };
+		}
+
+		std::vector<Vertex> lines;
+		std::vector<Vertex> triangles;
+		std::vector<std::pair<glm::vec2, std::string>> labels;
+		//Reused by Circle
+		std::vector<Vector2> circle;
+
+		TextRender* font = nullptr;
+		std::string fontStyle;
+		float labelScale = 0.5f;
+
+		Shader* shader;
+		unsigned int VAO = 0, VBO = 0;
+	};
+}
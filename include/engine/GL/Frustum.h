@@ -0,0 +1,99 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cmath>
+#include <limits>
+
+namespace engine
+{
+	//Axis aligned bounding box
+	struct AABB
+	{
+		glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+		glm::vec3 max = glm::vec3(std::numeric_limits<float>::lowest());
+
+		//Grow the box to contain point
+		void Expand(const glm::vec3& point)
+		{
+			min = glm::min(min, point);
+			max = glm::max(max, point);
+		}
+		void Expand(const AABB& other)
+		{
+			min = glm::min(min, other.min);
+			max = glm::max(max, other.max);
+		}
+
+		//A box with nothing added to it is empty
+		bool Empty() const
+		{
+			return min.x > max.x;
+		}
+
+		bool Overlaps(const AABB& other) const
+		{
+			return min.x <= other.max.x && max.x >= other.min.x
+				&& min.y <= other.max.y && max.y >= other.min.y
+				&& min.z <= other.max.z && max.z >= other.min.z;
+		}
+
+		//The box containing this box after being transformed by matrix
+		AABB Transformed(const glm::mat4& matrix) const
+		{
+			//Transform the center and project the extents onto each axis, cheaper than transforming all 8 corners
+			glm::vec3 center = (min + max) * 0.5f;
+			glm::vec3 extents = (max - min) * 0.5f;
+
+			glm::vec3 newCenter = glm::vec3(matrix * glm::vec4(center, 1));
+			glm::mat3 absolute = glm::mat3(glm::abs(glm::vec3(matrix[0])), glm::abs(glm::vec3(matrix[1])), glm::abs(glm::vec3(matrix[2])));
+			glm::vec3 newExtents = absolute * extents;
+
+			return AABB{ newCenter - newExtents, newCenter + newExtents };
+		}
+	};
+
+	//The six planes of a camera's view volume, used to check if something can be seen
+	class Frustum
+	{
+	public:
+		//Extract the planes from a combined projection * view matrix
+		Frustum(const glm::mat4& viewProjection)
+		{
+			//glm is column major, so pick out the rows
+			glm::vec4 rows[4];
+			for (int i = 0; i < 4; i++)
+				rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+
+			planes[0] = rows[3] + rows[0]; //Left
+			planes[1] = rows[3] - rows[0]; //Right
+			planes[2] = rows[3] + rows[1]; //Bottom
+			planes[3] = rows[3] - rows[1]; //Top
+			planes[4] = rows[3] + rows[2]; //Near
+			planes[5] = rows[3] - rows[2]; //Far
+
+			//The world space box around the whole volume, from the corners of clip space
+			glm::mat4 inverse = glm::inverse(viewProjection);
+			for (int i = 0; i < 8; i++)
+			{
+				glm::vec4 corner = inverse * glm::vec4(i & 1 ? 1 : -1, i & 2 ? 1 : -1, i & 4 ? 1 : -1, 1);
+				bounds.Expand(glm::vec3(corner) / corner.w);
+			}
+		}
+
+		//Returns true if any part of box might be inside the frustum
+		bool Intersects(const AABB& box) const
+		{
+			for (const glm::vec4& plane : planes)
+			{
+				//The corner furthest along the plane's normal, if even that is behind the plane the whole box is
+				glm::vec3 corner(plane.x >= 0 ? box.max.x : box.min.x, plane.y >= 0 ? box.max.y : box.min.y, plane.z >= 0 ? box.max.z : box.min.z);
+				if (glm::dot(glm::vec3(plane), corner) + plane.w < 0)
+					return false;
+			}
+			return true;
+		}
+
+		glm::vec4 planes[6];
+		//World space box containing the frustum
+		AABB bounds;
+	};
+}
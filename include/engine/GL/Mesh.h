@@ -2,9 +2,12 @@
 #include <glm/glm.hpp>
 #include <string>
 #include <vector>
+#include <cstdint>
+#include <cmath>
 #include <engine/GL/Shader.h>
 #include <glm/gtc/type_ptr.hpp>
 #include <engine/GL/Texture.h>
+#include <engine/GL/Frustum.h>
 
 namespace engine
 {
@@ -18,14 +21,100 @@ namespace engine
 			glm::vec2 TexCoords;
 		};
 
-		Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture*> textures);
+		//How the vertices are stored on the GPU
+		enum class VertexFormat
+		{
+			//Vertex as is, 32 bytes
+			standard = 0,
+			//Normal packed into 10 bits per axis, 24 bytes
+			packedNormals = 1
+		};
+
+		//Vertex with the normal packed into GL_INT_2_10_10_10_REV
+		struct PackedVertex
+		{
+			glm::vec3 Position;
+			uint32_t Normal;
+			glm::vec2 TexCoords;
+		};
+
+		//Indices are uploaded as 16-bit whenever there are few enough vertices
+		//The vertices and indices are freed once uploaded, unless keepData is true, for example for collision or picking
+		Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture*> textures, VertexFormat format = VertexFormat::standard, bool keepData = false);
+		//Upload straight from memory, for example a memory mapped cooked model
+		//The vertices must already be in format, indexType is GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, bounds are the local space bounds of the vertices
+		Mesh(const void* vertices, size_t vertexCount, VertexFormat format, const void* indices, size_t indexCount, unsigned int indexType, std::vector<Texture*> textures, const AABB& bounds, bool keepData = false);
+		~Mesh();
+
+		//A mesh owns its buffers, so it can only be moved
+		Mesh(const Mesh&) = delete;
+		Mesh& operator=(const Mesh&) = delete;
+		Mesh(Mesh&& other) noexcept;
+		Mesh& operator=(Mesh&& other) noexcept;
+
+		static size_t VertexSize(VertexFormat format)
+		{
+			return format == VertexFormat::packedNormals ? sizeof(PackedVertex) : sizeof(Vertex);
+		}
+		static size_t IndexSize(unsigned int indexType)
+		{
+			return indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+		}
+		//The smallest index type able to address vertexCount vertices
+		static unsigned int IndexTypeFor(size_t vertexCount)
+		{
+			return vertexCount <= 0x10000 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+		}
+
+		static uint32_t PackNormal(const glm::vec3& normal)
+		{
+			//Signed 10-bit components, x in the lowest bits
+			glm::vec3 clamped = glm::clamp(normal, -1.0f, 1.0f);
+			uint32_t x = (uint32_t)(int32_t)std::round(clamped.x * 511.0f) & 0x3FF;
+			uint32_t y = (uint32_t)(int32_t)std::round(clamped.y * 511.0f) & 0x3FF;
+			uint32_t z = (uint32_t)(int32_t)std::round(clamped.z * 511.0f) & 0x3FF;
+			return x | (y << 10) | (z << 20);
+		}
+		static glm::vec3 UnpackNormal(uint32_t packed)
+		{
+			//Shift each component to the top and back down to sign extend it
+			glm::vec3 normal;
+			for (int i = 0; i < 3; i++)
+				normal[i] = glm::max((float)((int32_t)(packed << (22 - i * 10)) >> 22) / 511.0f, -1.0f);
+			return normal;
+		}
 
-		//Mesh data
+		//True if the CPU side copies of the vertices and indices were kept after uploading
+		bool HasData() const
+		{
+			return keptData;
+		}
+
+		//Mesh data, empty unless the mesh was created with keepData
 		std::vector<Vertex> vertices;
 		std::vector<unsigned int> indices;
 		std::vector<Texture*> textures;
+		//Material slot of each texture, such as "texture_diffuse". Kept here because a texture is shared between every mesh using its image
+		std::vector<std::string> textureTypes;
 
 		//Buffer Data
-		unsigned int VAO, VBO, EBO;
+		unsigned int VAO = 0, VBO = 0, EBO = 0;
+		//What to give glDrawElements
+		unsigned int vertexCount = 0;
+		unsigned int indexCount = 0;
+		unsigned int indexType = GL_UNSIGNED_INT;
+		VertexFormat vertexFormat = VertexFormat::standard;
+
+		//Local space bounds of the vertices
+		AABB bounds;
+
+		//True once the vertex array has the instance attributes of the instanced model renderer enabled
+		bool instanceAttributes = false;
+
+	private:
+		void Upload(const void* vertexData, const void* indexData);
+		void Release();
+
+		bool keptData = false;
 	};
 }
\ No newline at end of file
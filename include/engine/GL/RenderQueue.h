@@ -0,0 +1,103 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+namespace engine
+{
+	//A flat list of things to draw, each with a 64-bit sort key, radix sorted once per frame
+	//Drawing in key order draws back to front by depth, and within a depth groups everything sharing a shader and texture
+	//The memory is kept between frames so building the queue doesn't allocate once it has grown to size
+	class RenderQueue
+	{
+	public:
+		//What kind of item a key belongs to. Tilemap layers come before sprites on the same depth
+		enum class ItemType { tilemap = 0, sprite = 1 };
+
+		struct Item
+		{
+			uint64_t key;
+			//What the item refers to, for example an entity or a tilemap layer index
+			unsigned int index;
+		};
+
+		//Build a sort key. The bits from most to least significant are:
+		//depth 32 | type 1 | ui element 1 | shader 12 | texture 18
+		//Shader and texture ids are truncated, which only matters for grouping, never for correctness
+		static uint64_t MakeKey(float depth, ItemType type, bool uiElement, unsigned int shader, unsigned int texture)
+		{
+			uint64_t key = (uint64_t)OrderableFloat(depth) << 32;
+			key |= (uint64_t)type << 31;
+			key |= (uint64_t)uiElement << 30;
+			key |= (uint64_t)(shader & 0xFFF) << 18;
+			key |= (uint64_t)(texture & 0x3FFFF);
+			return key;
+		}
+
+		static ItemType GetType(uint64_t key)
+		{
+			return (ItemType)((key >> 31) & 1);
+		}
+
+		void Clear()
+		{
+			items.clear();
+		}
+
+		void Push(uint64_t key, unsigned int index)
+		{
+			items.push_back(Item{ key, index });
+		}
+
+		//Sort the items by key, equal keys keep the order they were pushed in
+		//Least significant digit radix sort, one byte per pass. Passes where every key has the same byte are skipped,
+		//so keys which only differ in depth and shader cost only a few passes
+		void Sort()
+		{
+			if (items.size() < 2)
+				return;
+
+			scratch.resize(items.size());
+			for (unsigned int shift = 0; shift < 64; shift += 8)
+			{
+				size_t counts[256] = {};
+				for (const Item& item : items)
+					counts[(item.key >> shift) & 0xFF]++;
+
+				if (counts[(items[0].key >> shift) & 0xFF] == items.size())
+					continue;
+
+				//Turn the counts into the first output index of each digit
+				size_t offset = 0;
+				for (size_t& count : counts)
+				{
+					size_t digitCount = count;
+					count = offset;
+					offset += digitCount;
+				}
+
+				for (const Item& item : items)
+					scratch[counts[(item.key >> shift) & 0xFF]++] = item;
+				items.swap(scratch);
+			}
+		}
+
+		std::vector<Item> items;
+
+	private:
+		//Map a float to an unsigned int which sorts in the same order, negative numbers included
+		static uint32_t OrderableFloat(float value)
+		{
+			//Negative zero would otherwise sort before positive zero
+			if (value == 0)
+				value = 0;
+
+			uint32_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			return (bits & 0x80000000) ? ~bits : bits | 0x80000000;
+		}
+
+		std::vector<Item> scratch;
+	};
+}
@@ -0,0 +1,410 @@
+#pragma once
+#include <glad/gl.h>
+#include <array>
+#include <vector>
+#include <string>
+
+namespace engine
+{
+	//The OpenGL state changing calls the render state forwards to
+	//Swapping the backend lets the render state run without a GPU
+	class RenderBackend
+	{
+	public:
+		virtual ~RenderBackend() {};
+
+		virtual void UseProgram(unsigned int program) = 0;
+		virtual void BindVertexArray(unsigned int vao) = 0;
+		virtual void BindBuffer(unsigned int target, unsigned int buffer) = 0;
+		virtual void BindBufferRange(unsigned int target, unsigned int index, unsigned int buffer, long long offset, long long size) = 0;
+		virtual void ActiveTexture(unsigned int unit) = 0;
+		virtual void BindTexture(unsigned int target, unsigned int texture) = 0;
+		virtual void SetCapability(unsigned int capability, bool enabled) = 0;
+		virtual void BlendFunc(unsigned int source, unsigned int destination) = 0;
+		virtual void DepthFunc(unsigned int function) = 0;
+	};
+
+	//Backend which calls straight into OpenGL
+	class GLRenderBackend : public RenderBackend
+	{
+	public:
+		void UseProgram(unsigned int program) override
+		{
+			glUseProgram(program);
+		}
+		void BindVertexArray(unsigned int vao) override
+		{
+			glBindVertexArray(vao);
+		}
+		void BindBuffer(unsigned int target, unsigned int buffer) override
+		{
+			glBindBuffer(target, buffer);
+		}
+		void BindBufferRange(unsigned int target, unsigned int index, unsigned int buffer, long long offset, long long size) override
+		{
+			glBindBufferRange(target, index, buffer, offset, size);
+		}
+		void ActiveTexture(unsigned int unit) override
+		{
+			glActiveTexture(GL_TEXTURE0 + unit);
+		}
+		void BindTexture(unsigned int target, unsigned int texture) override
+		{
+			glBindTexture(target, texture);
+		}
+		void SetCapability(unsigned int capability, bool enabled) override
+		{
+			if (enabled)
+				glEnable(capability);
+			else
+				glDisable(capability);
+		}
+		void BlendFunc(unsigned int source, unsigned int destination) override
+		{
+			glBlendFunc(source, destination);
+		}
+		void DepthFunc(unsigned int function) override
+		{
+			glDepthFunc(function);
+		}
+	};
+
+	//Backend which only records the calls made to it, for running the renderers with no OpenGL context
+	class RecordingRenderBackend : public RenderBackend
+	{
+	public:
+		struct Call
+		{
+			std::string function;
+			std::vector<long long> arguments;
+		};
+
+		void UseProgram(unsigned int program) override
+		{
+			calls.push_back({ "UseProgram", { program } });
+		}
+		void BindVertexArray(unsigned int vao) override
+		{
+			calls.push_back({ "BindVertexArray", { vao } });
+		}
+		void BindBuffer(unsigned int target, unsigned int buffer) override
+		{
+			calls.push_back({ "BindBuffer", { target, buffer } });
+		}
+		void BindBufferRange(unsigned int target, unsigned int index, unsigned int buffer, long long offset, long long size) override
+		{
+			calls.push_back({ "BindBufferRange", { target, index, buffer, offset, size } });
+		}
+		void ActiveTexture(unsigned int unit) override
+		{
+			calls.push_back({ "ActiveTexture", { unit } });
+		}
+		void BindTexture(unsigned int target, unsigned int texture) override
+		{
+			calls.push_back({ "BindTexture", { target, texture } });
+		}
+		void SetCapability(unsigned int capability, bool enabled) override
+		{
+			calls.push_back({ "SetCapability", { capability, enabled } });
+		}
+		void BlendFunc(unsigned int source, unsigned int destination) override
+		{
+			calls.push_back({ "BlendFunc", { source, destination } });
+		}
+		void DepthFunc(unsigned int function) override
+		{
+			calls.push_back({ "DepthFunc", { function } });
+		}
+
+		std::vector<Call> calls;
+	};
+
+	//Tracks the currently bound OpenGL objects and render settings so redundant state changes are never sent to the driver
+	//Every engine renderer goes through this. If you make raw OpenGL state calls yourself, call Invalidate() afterwards
+	class RenderState
+	{
+	public:
+		static const int MAX_TEXTURE_UNITS = 16;
+
+		//Counts of state changes which were sent to the backend and which were skipped because they changed nothing
+		struct Stats
+		{
+			unsigned int issued = 0;
+			unsigned int skipped = 0;
+		};
+
+		//Get the shared render state, by default it calls OpenGL directly
+		static RenderState* Get()
+		{
+			static RenderState* state = new RenderState();
+			return state;
+		}
+
+		//Replace the backend, for example with a RecordingRenderBackend. The cache is reset
+		void SetBackend(RenderBackend* newBackend)
+		{
+			backend = newBackend;
+			Invalidate();
+		}
+
+		//Forget all tracked state so the next call of every kind goes through to the backend
+		void Invalidate()
+		{
+			program = UNKNOWN;
+			vertexArray = UNKNOWN;
+			buffers.fill(UNKNOWN);
+			uniformRanges.fill(BufferRange{ UNKNOWN, 0, 0 });
+			activeUnit = UNKNOWN;
+			textures.fill(UNKNOWN);
+			capabilities.clear();
+			blendSource = UNKNOWN;
+			blendDestination = UNKNOWN;
+			depthFunction = UNKNOWN;
+		}
+
+		//Start counting a new frame, the previous frame's counts are kept in lastFrame
+		void NewFrame()
+		{
+			lastFrame = frame;
+			frame = Stats();
+		}
+
+		void UseProgram(unsigned int newProgram)
+		{
+			if (Changed(program, newProgram))
+				backend->UseProgram(newProgram);
+		}
+
+		//Binding a vertex array also switches the element array buffer, which is part of the vertex array's state
+		void BindVertexArray(unsigned int vao)
+		{
+			if (Changed(vertexArray, vao))
+			{
+				backend->BindVertexArray(vao);
+				buffers[BufferSlot(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+			}
+		}
+
+		void BindBuffer(unsigned int target, unsigned int buffer)
+		{
+			int slot = BufferSlot(target);
+			if (slot < 0)
+			{
+				frame.issued++;
+				backend->BindBuffer(target, buffer);
+				return;
+			}
+			if (Changed(buffers[slot], buffer))
+				backend->BindBuffer(target, buffer);
+		}
+
+		//Bind a range of a buffer to an indexed uniform buffer binding point
+		void BindUniformBufferRange(unsigned int index, unsigned int buffer, long long offset, long long size)
+		{
+			BufferRange range{ buffer, offset, size };
+			if (index < uniformRanges.size() && uniformRanges[index] == range)
+			{
+				frame.skipped++;
+				return;
+			}
+			if (index < uniformRanges.size())
+				uniformRanges[index] = range;
+
+			frame.issued++;
+			backend->BindBufferRange(GL_UNIFORM_BUFFER, index, buffer, offset, size);
+			//Binding a range also binds the generic uniform buffer binding
+			buffers[BufferSlot(GL_UNIFORM_BUFFER)] = buffer;
+		}
+
+		//Bind a 2D texture to a texture unit, the unit is the index, not GL_TEXTUREi
+		void BindTexture(unsigned int unit, unsigned int texture)
+		{
+			if (unit >= MAX_TEXTURE_UNITS)
+			{
+				ActiveTexture(unit);
+				frame.issued++;
+				backend->BindTexture(GL_TEXTURE_2D, texture);
+				return;
+			}
+
+			if (textures[unit] == texture)
+			{
+				frame.skipped++;
+				return;
+			}
+
+			ActiveTexture(unit);
+			textures[unit] = texture;
+			frame.issued++;
+			backend->BindTexture(GL_TEXTURE_2D, texture);
+		}
+
+		//Bind a 2D texture to whichever unit is currently active, used when creating and modifying textures
+		void BindTexture(unsigned int texture)
+		{
+			BindTexture(activeUnit == UNKNOWN ? 0 : activeUnit, texture);
+		}
+
+		void ActiveTexture(unsigned int unit)
+		{
+			if (Changed(activeUnit, unit))
+				backend->ActiveTexture(unit);
+		}
+
+		//Enable or disable an OpenGL capability such as GL_BLEND or GL_DEPTH_TEST
+		void SetCapability(unsigned int capability, bool enabled)
+		{
+			for (auto& known : capabilities)
+			{
+				if (known.first == capability)
+				{
+					if (known.second == enabled)
+					{
+						frame.skipped++;
+						return;
+					}
+					known.second = enabled;
+					frame.issued++;
+					backend->SetCapability(capability, enabled);
+					return;
+				}
+			}
+
+			capabilities.push_back({ capability, enabled });
+			frame.issued++;
+			backend->SetCapability(capability, enabled);
+		}
+		void Enable(unsigned int capability)
+		{
+			SetCapability(capability, true);
+		}
+		void Disable(unsigned int capability)
+		{
+			SetCapability(capability, false);
+		}
+		//Whether capability was last enabled through the cache. Capabilities it doesn't know count as disabled, like OpenGL's default
+		bool IsEnabled(unsigned int capability) const
+		{
+			for (const auto& known : capabilities)
+				if (known.first == capability)
+					return known.second;
+			return false;
+		}
+
+		void BlendFunc(unsigned int source, unsigned int destination)
+		{
+			if (blendSource == source && blendDestination == destination)
+			{
+				frame.skipped++;
+				return;
+			}
+			blendSource = source;
+			blendDestination = destination;
+			frame.issued++;
+			backend->BlendFunc(source, destination);
+		}
+
+		void DepthFunc(unsigned int function)
+		{
+			if (Changed(depthFunction, function))
+				backend->DepthFunc(function);
+		}
+
+		//OpenGL unbinds deleted objects and reuses their names, so call these before deleting any tracked object
+		void DeleteTexture(unsigned int texture)
+		{
+			for (unsigned int& bound : textures)
+			{
+				if (bound == texture)
+					bound = 0;
+			}
+		}
+		void DeleteBuffer(unsigned int buffer)
+		{
+			for (unsigned int& bound : buffers)
+			{
+				if (bound == buffer)
+					bound = 0;
+			}
+			for (BufferRange& range : uniformRanges)
+			{
+				if (range.buffer == buffer)
+					range = BufferRange{ 0, 0, 0 };
+			}
+		}
+		void DeleteVertexArray(unsigned int vao)
+		{
+			if (vertexArray == vao)
+			{
+				vertexArray = 0;
+				buffers[BufferSlot(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+			}
+		}
+
+		//The current frame's counts, and the last full frame's counts
+		Stats frame;
+		Stats lastFrame;
+
+	private:
+		RenderState()
+		{
+			backend = &glBackend;
+			Invalidate();
+		}
+
+		//Value for state which might be anything, for example after raw OpenGL calls
+		static constexpr unsigned int UNKNOWN = 0xFFFFFFFF;
+
+		struct BufferRange
+		{
+			unsigned int buffer;
+			long long offset;
+			long long size;
+
+			bool operator==(const BufferRange& rhs) const
+			{
+				return buffer == rhs.buffer && offset == rhs.offset && size == rhs.size;
+			}
+		};
+
+		//Update a tracked value, returns true and counts the call as issued if it changed
+		bool Changed(unsigned int& current, unsigned int value)
+		{
+			if (current == value)
+			{
+				frame.skipped++;
+				return false;
+			}
+			current = value;
+			frame.issued++;
+			return true;
+		}
+
+		//Index of a buffer target in the tracked buffers, or -1 if it is not tracked
+		static int BufferSlot(unsigned int target)
+		{
+			switch (target)
+			{
+			case GL_ARRAY_BUFFER: return 0;
+			case GL_ELEMENT_ARRAY_BUFFER: return 1;
+			case GL_UNIFORM_BUFFER: return 2;
+			case GL_PIXEL_UNPACK_BUFFER: return 3;
+			default: return -1;
+			}
+		}
+
+		GLRenderBackend glBackend;
+		RenderBackend* backend;
+
+		unsigned int program;
+		unsigned int vertexArray;
+		std::array<unsigned int, 4> buffers;
+		std::array<BufferRange, 8> uniformRanges;
+		unsigned int activeUnit;
+		std::array<unsigned int, MAX_TEXTURE_UNITS> textures;
+		std::vector<std::pair<unsigned int, bool>> capabilities;
+		unsigned int blendSource;
+		unsigned int blendDestination;
+		unsigned int depthFunction;
+	};
+}
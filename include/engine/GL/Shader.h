@@ -4,9 +4,18 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <engine/GL/RenderState.h>
 
 namespace engine
 {
+	//The uniform buffer binding point of the shared camera block, see CameraUniformBuffer
+	//Shaders can declare layout(std140) uniform Camera { mat4 view; mat4 projection; }; instead of separate view and projection uniforms
+	const unsigned int CAMERA_UNIFORM_BINDING = 0;
+
 	//Abstraction class for OpenGL shaders
 	class Shader
 	{
@@ -104,14 +113,111 @@ namespace engine
 			//Delete the shader programs after they are no longer needed
 			glDeleteShader(vertexShader);
 			glDeleteShader(fragmentShader);
+
+			CacheUniforms();
 		}
 
 		//Use this shader program
 		void use()
 		{
-			glUseProgram(ID);
+			RenderState::Get()->UseProgram(ID);
+		}
+
+		//Get the location of a uniform from the table built after linking, returns -1 if there is no such active uniform
+		int GetUniformLocation(std::string_view name)
+		{
+			auto it = uniformLocations.find(name);
+			if (it == uniformLocations.end())
+				return -1;
+			return it->second;
+		}
+
+		//Typed uniform setters using the cached locations. The shader must be in use
+		void SetInt(std::string_view name, int value)
+		{
+			glUniform1i(GetUniformLocation(name), value);
+		}
+		void SetFloat(std::string_view name, float value)
+		{
+			glUniform1f(GetUniformLocation(name), value);
+		}
+		void SetVec2(std::string_view name, glm::vec2 value)
+		{
+			glUniform2fv(GetUniformLocation(name), 1, glm::value_ptr(value));
+		}
+		void SetVec3(std::string_view name, glm::vec3 value)
+		{
+			glUniform3fv(GetUniformLocation(name), 1, glm::value_ptr(value));
+		}
+		void SetVec4(std::string_view name, glm::vec4 value)
+		{
+			glUniform4fv(GetUniformLocation(name), 1, glm::value_ptr(value));
+		}
+		void SetMat4(std::string_view name, const glm::mat4& value)
+		{
+			glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, glm::value_ptr(value));
 		}
 
 		unsigned int ID;
+		//True if the shader declares the shared Camera uniform block
+		bool hasCameraBlock = false;
+
+	private:
+		//Lets the location table be searched with a string_view without allocating a string
+		struct NameHash
+		{
+			using is_transparent = void;
+			size_t operator()(std::string_view name) const
+			{
+				return std::hash<std::string_view>()(name);
+			}
+		};
+
+		//Introspect every active uniform once so they never have to be looked up by string through the driver again
+		void CacheUniforms()
+		{
+			int uniformCount = 0;
+			glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &uniformCount);
+
+			char name[256];
+			for (int i = 0; i < uniformCount; i++)
+			{
+				int length, size;
+				unsigned int type;
+				glGetActiveUniform(ID, i, sizeof(name), &length, &size, &type, name);
+
+				//Uniforms in blocks don't have locations
+				int location = glGetUniformLocation(ID, name);
+				if (location == -1)
+					continue;
+
+				std::string uniformName(name, length);
+				uniformLocations[uniformName] = location;
+
+				//Arrays are reported once as name[0], make them accessible by just name and every element by name[i] as well
+				if (uniformName.ends_with("[0]"))
+				{
+					std::string arrayName = uniformName.substr(0, uniformName.size() - 3);
+					uniformLocations[arrayName] = location;
+					for (int element = 1; element < size; element++)
+					{
+						std::string elementName = arrayName + "[" + std::to_string(element) + "]";
+						int elementLocation = glGetUniformLocation(ID, elementName.c_str());
+						if (elementLocation != -1)
+							uniformLocations[elementName] = elementLocation;
+					}
+				}
+			}
+
+			//Connect the camera block to the shared camera uniform buffer
+			unsigned int cameraBlock = glGetUniformBlockIndex(ID, "Camera");
+			if (cameraBlock != GL_INVALID_INDEX)
+			{
+				glUniformBlockBinding(ID, cameraBlock, CAMERA_UNIFORM_BINDING);
+				hasCameraBlock = true;
+			}
+		}
+
+		std::unordered_map<std::string, int, NameHash, std::equal_to<>> uniformLocations;
 	};
 }
\ No newline at end of file
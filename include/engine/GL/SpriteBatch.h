@@ -0,0 +1,237 @@
+#pragma once
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <assert.h>
+#include <engine/GL/Shader.h>
+#include <engine/GL/RenderState.h>
+
+namespace engine
+{
+	//Collects sprite quads into as few draw calls as possible
+	//Consecutive quads sharing the same texture, shader, and view are merged into one batch
+	//Quads can either be transformed on the CPU into a streamed vertex buffer, or added as instances of a shared quad
+	//Adding quads is done purely on the CPU, only Upload() and Draw() touch OpenGL
+	class SpriteBatch
+	{
+	public:
+		struct Vertex
+		{
+			glm::vec3 position;
+			glm::vec2 texCoords;
+		};
+
+		//Per-sprite data for instanced drawing, 64 bytes
+		struct Instance
+		{
+			//The first three rows of the model matrix, the last row of an affine matrix is always 0, 0, 0, 1
+			glm::vec4 modelRows[3];
+			glm::vec4 uvRect;
+		};
+
+		//A run of consecutive quads which can be drawn with one draw call
+		struct Batch
+		{
+			unsigned int texture = 0;
+			Shader* shader = nullptr;
+			bool uiElement = false;
+			bool instanced = false;
+			//Index of the first quad in either vertices or instances
+			unsigned int firstQuad = 0;
+			unsigned int quadCount = 0;
+		};
+
+		SpriteBatch() {};
+		SpriteBatch(const SpriteBatch&) = delete;
+		SpriteBatch& operator=(const SpriteBatch&) = delete;
+
+		~SpriteBatch()
+		{
+			if (VAO)
+			{
+				RenderState::Get()->DeleteVertexArray(VAO);
+				RenderState::Get()->DeleteBuffer(VBO);
+				RenderState::Get()->DeleteBuffer(EBO);
+				glDeleteVertexArrays(1, &VAO);
+				glDeleteBuffers(1, &VBO);
+				glDeleteBuffers(1, &EBO);
+			}
+			if (instanceVBO)
+			{
+				RenderState::Get()->DeleteBuffer(instanceVBO);
+				glDeleteBuffers(1, &instanceVBO);
+			}
+		}
+
+		//Remove every quad and batch, the memory is kept for the next frame
+		void Clear()
+		{
+			vertices.clear();
+			instances.clear();
+			batches.clear();
+			split = false;
+		}
+
+		//Make the next quad start a new batch even if it could be merged, for drawing something else in between
+		void Split()
+		{
+			split = true;
+		}
+
+		//Add the default sprite quad transformed by model, uvRect is the min x, min y, max x, max y of the texture coordinates
+		void Add(const glm::mat4& model, unsigned int texture, Shader* shader, bool uiElement, glm::vec4 uvRect = glm::vec4(0, 0, 1, 1))
+		{
+			AddToBatch(texture, shader, uiElement, false, vertices.size() / 4);
+
+			//The quad goes from -1 to 1 so each corner is just the translation plus or minus the x and y axes of the model matrix
+			glm::vec3 right = glm::vec3(model[0]);
+			glm::vec3 up = glm::vec3(model[1]);
+			glm::vec3 center = glm::vec3(model[3]);
+
+			//Same corner order as the sprite render system's quad, top right going clockwise
+			vertices.push_back(Vertex{ center + right + up, glm::vec2(uvRect.z, uvRect.w) });
+			vertices.push_back(Vertex{ center + right - up, glm::vec2(uvRect.z, uvRect.y) });
+			vertices.push_back(Vertex{ center - right - up, glm::vec2(uvRect.x, uvRect.y) });
+			vertices.push_back(Vertex{ center - right + up, glm::vec2(uvRect.x, uvRect.w) });
+		}
+
+		//Add an instance of the shared quad. The shader must read the instance attributes at locations 2 to 5
+		void AddInstance(const glm::mat4& model, unsigned int texture, Shader* shader, bool uiElement, glm::vec4 uvRect = glm::vec4(0, 0, 1, 1))
+		{
+			AddToBatch(texture, shader, uiElement, true, instances.size());
+
+			//glm matrices are column major, so pick the rows out manually
+			Instance instance;
+			for (int row = 0; row < 3; row++)
+				instance.modelRows[row] = glm::vec4(model[0][row], model[1][row], model[2][row], model[3][row]);
+			instance.uvRect = uvRect;
+			instances.push_back(instance);
+		}
+
+		//Stream every added quad and instance to the GPU
+		//quadVAO is the vertex array of the shared quad used for instanced batches, its element buffer must contain one quad
+		//The buffers are orphaned each time so the driver doesn't have to wait for the previous frame's draws
+		void Upload(unsigned int quadVAO = 0)
+		{
+			if (!vertices.empty())
+			{
+				if (!VAO)
+					CreateBuffers();
+
+				RenderState::Get()->BindVertexArray(VAO);
+
+				//Grow the index buffer if there are more quads than ever before
+				unsigned int quadCount = vertices.size() / 4;
+				if (quadCount > indexCapacity)
+					ReserveIndices(quadCount);
+
+				RenderState::Get()->BindBuffer(GL_ARRAY_BUFFER, VBO);
+				glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), nullptr, GL_STREAM_DRAW);
+				glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(Vertex), vertices.data());
+			}
+
+			if (!instances.empty())
+			{
+				assert(quadVAO && "Instanced sprites need the shared quad vertex array!");
+				instanceVAO = quadVAO;
+				if (!instanceVBO)
+					glGenBuffers(1, &instanceVBO);
+
+				RenderState::Get()->BindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+				glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(Instance), nullptr, GL_STREAM_DRAW);
+				glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(Instance), instances.data());
+			}
+		}
+
+		//Draw one batch. Upload() must have been called after the last Add()
+		void Draw(const Batch& batch)
+		{
+			if (!batch.instanced)
+			{
+				RenderState::Get()->BindVertexArray(VAO);
+				glDrawElements(GL_TRIANGLES, batch.quadCount * 6, GL_UNSIGNED_INT, (void*)(batch.firstQuad * 6 * sizeof(unsigned int)));
+				return;
+			}
+
+			RenderState::Get()->BindVertexArray(instanceVAO);
+			RenderState::Get()->BindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+
+			//OpenGL 3.3 has no base instance, so point the instance attributes at this batch's first instance instead
+			size_t offset = batch.firstQuad * sizeof(Instance);
+			for (unsigned int i = 0; i < 4; i++)
+			{
+				glVertexAttribPointer(2 + i, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(offset + i * sizeof(glm::vec4)));
+				glVertexAttribDivisor(2 + i, 1);
+				glEnableVertexAttribArray(2 + i);
+			}
+
+			glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0, batch.quadCount);
+		}
+
+		std::vector<Vertex> vertices;
+		std::vector<Instance> instances;
+		std::vector<Batch> batches;
+
+	private:
+		//Extend the last batch, or start a new one if anything affecting the draw call changed
+		void AddToBatch(unsigned int texture, Shader* shader, bool uiElement, bool instanced, unsigned int quadIndex)
+		{
+			if (split || batches.empty() || batches.back().texture != texture || batches.back().shader != shader || batches.back().uiElement != uiElement || batches.back().instanced != instanced)
+			{
+				Batch batch;
+				batch.texture = texture;
+				batch.shader = shader;
+				batch.uiElement = uiElement;
+				batch.instanced = instanced;
+				batch.firstQuad = quadIndex;
+				batches.push_back(batch);
+				split = false;
+			}
+			batches.back().quadCount++;
+		}
+
+		void CreateBuffers()
+		{
+			glGenVertexArrays(1, &VAO);
+			glGenBuffers(1, &VBO);
+			glGenBuffers(1, &EBO);
+
+			RenderState::Get()->BindVertexArray(VAO);
+			RenderState::Get()->BindBuffer(GL_ARRAY_BUFFER, VBO);
+			RenderState::Get()->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+
+			//Same attribute locations as the default sprite quad
+			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
+			glEnableVertexAttribArray(0);
+			glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoords));
+			glEnableVertexAttribArray(1);
+
+			ReserveIndices(1024);
+		}
+
+		//Fill the index buffer with two triangles for each quad. The vertex array must be bound
+		void ReserveIndices(unsigned int quadCount)
+		{
+			//Grow by doubling to avoid regenerating the indices every frame while the sprite count climbs
+			indexCapacity = std::max(quadCount, indexCapacity * 2);
+
+			std::vector<unsigned int> indices;
+			indices.reserve(indexCapacity * 6);
+			for (unsigned int i = 0; i < indexCapacity; i++)
+			{
+				unsigned int first = i * 4;
+				indices.insert(indices.end(), { first, first + 1, first + 2, first, first + 2, first + 3 });
+			}
+
+			RenderState::Get()->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+		}
+
+		unsigned int VAO = 0, VBO = 0, EBO = 0;
+		unsigned int indexCapacity = 0;
+		unsigned int instanceVAO = 0, instanceVBO = 0;
+		bool split = false;
+	};
+}
@@ -5,11 +5,16 @@
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 #include <stb_image.h>
+#include <engine/GL/RenderState.h>
+#include <engine/FileSystem.h>
+#include <engine/GL/TextureMemory.h>
+#include <vector>
+#include <algorithm>
 
 namespace engine
 {
-	//Forward declare Image class for second constructor
-	class Image;
+	//Forward declare ImageView class for second constructor
+	class ImageView;
 
 	//Abstraction class for OpenGL textures
 	class Texture
@@ -23,7 +28,7 @@ namespace engine
 		{
 			//Generate and bind texture
 			glGenTextures(1, &id);
-			glBindTexture(GL_TEXTURE_2D, id);
+			RenderState::Get()->BindTexture(id);
 
 			glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16UI, sx, sy, 0, GL_RG_INTEGER, GL_UNSIGNED_SHORT, &data[0]);
 
@@ -31,16 +36,145 @@ namespace engine
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+			TextureMemory::Get()->Register(this);
+			SetMemorySize((size_t)sx * sy * 4);
 		}
 
 		//Load a texture from path
+		//Textures loaded from a file can be evicted by TextureMemory when unused and are then loaded again when next used
 		Texture(const char* path, unsigned int filteringType = GL_NEAREST, bool flip = true)
+			: filteringType(filteringType), flip(flip), sourcePath(path)
+		{
+			TextureMemory::Get()->Register(this);
+			reloadable = LoadFile();
+		}
+		//Create an empty RGBA texture, filled in later with SetSubImage
+		Texture(int width, int height, unsigned int filteringType)
+		{
+			glGenTextures(1, &id);
+			RenderState::Get()->BindTexture(id);
+
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filteringType);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filteringType);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+			this->filteringType = filteringType;
+			TextureMemory::Get()->Register(this);
+			SetMemorySize((size_t)width * height * 4);
+		}
+		//Declare the constuctor through an image or a view of one. It is defined in Image.h
+		inline Texture(const ImageView& image, unsigned int filteringType = GL_NEAREST);
+
+		~Texture()
+		{
+			//Stop a background load from writing to the deleted texture
+			if (loading && cancelLoading)
+				cancelLoading(this);
+
+			RenderState::Get()->DeleteTexture(id);
+			glDeleteTextures(1, &id);
+			SetMemorySize(0);
+			TextureMemory::Get()->Unregister(this);
+		}
+
+		//Sets the OpenGL sampling type when up and downscaling the texture. Ex. GL_NEAREST, GL_LINEAR, etc.
+		void SetScalingFilter(unsigned int type)
+		{
+			filteringType = type;
+			RenderState::Get()->BindTexture(ID());
+
+			//Set texture filtering parameters
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, type);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, type);
+
+			//Unbind texture
+			RenderState::Get()->BindTexture(0);
+		}
+
+		//Replace a rectangle of this RGBA texture, x and y are from the bottom left corner
+		//pixels are RGBA going from the bottom row up, rowLength is how many pixels apart the rows are, 0 if they are tightly packed
+		void SetSubImage(int x, int y, int width, int height, const unsigned char* pixels, int rowLength = 0)
+		{
+			RenderState::Get()->BindTexture(ID());
+
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+			glPixelStorei(GL_UNPACK_ROW_LENGTH, rowLength);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+			glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+		}
+
+		//Get this textures OpenGL ID. Asking for it counts as using the texture, an evicted texture is loaded again
+		unsigned int ID()
+		{
+			lastUsedFrame = TextureMemory::Get()->Frame();
+			if (!resident)
+				Reload();
+			return id;
+		}
+
+		//Use this texture to draw the next sprite
+		void Use()
+		{
+			RenderState::Get()->BindTexture(ID());
+		}
+		//Bind this texture to a texture unit, unit is the index and not GL_TEXTUREi
+		void Use(unsigned int unit)
+		{
+			RenderState::Get()->BindTexture(unit, ID());
+		}
+
+		//GPU memory used by this texture in bytes, including mipmaps
+		size_t MemorySize() const
+		{
+			return memorySize;
+		}
+
+		//False while the texture is evicted
+		bool IsResident() const
+		{
+			return resident;
+		}
+
+		//Free the texture's GPU memory if it can be loaded again from its file, returns false if it can't
+		bool Evict()
+		{
+			if (!reloadable || !resident)
+				return false;
+
+			RenderState::Get()->DeleteTexture(id);
+			glDeleteTextures(1, &id);
+			id = 0;
+			resident = false;
+			SetMemorySize(0);
+			return true;
+		}
+
+		std::string path = "";
+		std::string type = "";
+	private:
+		friend class TextureLoader;
+		friend class TextureMemory;
+
+		//True while TextureLoader is loading an image into this texture
+		bool loading = false;
+		//Cancels the load of a texture being deleted, set by TextureLoader so textures don't depend on it
+		static inline void (*cancelLoading)(Texture*) = nullptr;
+
+		//Load the image at sourcePath into the texture, making a new OpenGL texture if there isn't one
+		bool LoadFile()
 		{
 			//Flip the image when loading into an OpenGL texture
 			stbi_set_flip_vertically_on_load(flip);
-			//Load image
+			//Load image, from a mounted asset pack if it has it
 			int width, height, nrChannels;
-			unsigned char* imageData = stbi_load(path, &width, &height, &nrChannels, 0);
+			FileView file = FileSystem::Get()->Find(sourcePath);
+			unsigned char* imageData = file
+				? stbi_load_from_memory(file.data, (int)file.size, &width, &height, &nrChannels, 0)
+				: stbi_load(sourcePath.c_str(), &width, &height, &nrChannels, 0);
 
 			if (imageData)
 			{
@@ -62,8 +196,9 @@ namespace engine
 				}
 
 				//Generate and bind texture
-				glGenTextures(1, &id);
-				glBindTexture(GL_TEXTURE_2D, id);
+				if (!id)
+					glGenTextures(1, &id);
+				RenderState::Get()->BindTexture(id);
 
 				//Set texture filtering parameters
 				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filteringType);
@@ -74,52 +209,87 @@ namespace engine
 				glGenerateMipmap(GL_TEXTURE_2D);
 
 				//Unbind texture
-				glBindTexture(GL_TEXTURE_2D, 0);
+				RenderState::Get()->BindTexture(0);
 
 				//Image data is no longer needed
 				stbi_image_free(imageData);
+
+				//The mipmaps add a third on top of the full size image
+				SetMemorySize((size_t)width * height * nrChannels * 4 / 3);
+				return true;
 			}
 			else
 			{
-				std::cout << "Error loading texture from " << path << std::endl;
+				std::cout << "Error loading texture from " << sourcePath << std::endl;
+				return false;
 			}
 		}
-		//Declare the constuctor through image. It is defined in Image.h
-		inline Texture(Image image, unsigned int filteringType = GL_NEAREST);
 
-		~Texture()
+		void Reload()
 		{
-			glDeleteTextures(1, &id);
+			resident = true;
+			if (!LoadFile())
+				reloadable = false;
 		}
 
-		//Sets the OpenGL sampling type when up and downscaling the texture. Ex. GL_NEAREST, GL_LINEAR, etc.
-		void SetScalingFilter(unsigned int type)
+		//Keep TextureMemory's total up to date
+		void SetMemorySize(size_t bytes)
 		{
-			glBindTexture(GL_TEXTURE_2D, id);
+			TextureMemory::Get()->Resize(memorySize, bytes);
+			memorySize = bytes;
+		}
 
-			//Set texture filtering parameters
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, type);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, type);
+		unsigned int id = 0;
+		unsigned int filteringType = GL_NEAREST;
+		bool flip = true;
+		std::string sourcePath;
+		//Only textures loaded from a file can be evicted
+		bool reloadable = false;
+		bool resident = true;
+		size_t memorySize = 0;
+		uint64_t lastUsedFrame = 0;
+	};
 
-			//Unbind texture
-			glBindTexture(GL_TEXTURE_2D, 0);
-		}
+	void TextureMemory::Update()
+	{
+		frame++;
+		if (residentBytes <= budget)
+			return;
 
-		//Get this textures OpenGL ID
-		unsigned int ID()
+		//Evict the least recently used textures until under budget
+		std::vector<Texture*> unused;
+		for (Texture* texture : textures)
 		{
-			return id;
+			if (texture->reloadable && texture->resident && frame - texture->lastUsedFrame >= unusedFrames)
+				unused.push_back(texture);
 		}
+		std::sort(unused.begin(), unused.end(), [](Texture* a, Texture* b) { return a->lastUsedFrame < b->lastUsedFrame; });
 
-		//Use this texture to draw the next sprite
-		void Use()
+		for (Texture* texture : unused)
 		{
-			glBindTexture(GL_TEXTURE_2D, id);
+			if (residentBytes <= budget)
+				break;
+			texture->Evict();
 		}
+	}
 
-		std::string path = "";
-		std::string type = "";
-	private:
-		unsigned int id = 0;
-	};
+	void TextureMemory::PrintReport() const
+	{
+		std::vector<Texture*> sorted(textures.begin(), textures.end());
+		std::sort(sorted.begin(), sorted.end(), [](Texture* a, Texture* b) { return a->memorySize > b->memorySize; });
+
+		size_t evicted = 0;
+		for (Texture* texture : sorted)
+			evicted += !texture->resident;
+
+		std::cout << "Texture memory: " << residentBytes / 1024 << " KB of " << budget / 1024 << " KB, "
+			<< textures.size() - evicted << " textures resident, " << evicted << " evicted" << std::endl;
+		for (Texture* texture : sorted)
+		{
+			if (!texture->resident)
+				continue;
+			std::cout << "  " << texture->memorySize / 1024 << " KB, unused for " << frame - texture->lastUsedFrame << " frames, "
+				<< (texture->reloadable ? texture->sourcePath : "not evictable") << std::endl;
+		}
+	}
 }
\ No newline at end of file
@@ -0,0 +1,263 @@
+#pragma once
+#include <glad/gl.h>
+#include <stb_image.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <thread>
+#include <semaphore>
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+#include <engine/GL/Texture.h>
+#include <engine/GL/RenderState.h>
+#include <engine/BoundedQueue.h>
+
+namespace engine
+{
+	//Loads textures in the background so loading screens and streaming don't stall the game
+	//Images are decoded on worker threads and handed back to the main thread through a lock-free queue,
+	//then copied into a pixel buffer object a budgeted amount per frame and uploaded to the texture from it
+	//Load returns a placeholder texture right away, which becomes the real texture when it is done, keeping the same id
+	class TextureLoader
+	{
+	public:
+		//Get the shared texture loader. OpenGL must be initialized
+		static TextureLoader* Get()
+		{
+			static TextureLoader* loader = new TextureLoader();
+			return loader;
+		}
+
+		//Start loading the texture at path. The returned texture is a 1x1 white placeholder until the image is uploaded
+		//The texture can be used like any other, deleting it while it is still loading cancels the load
+		Texture* Load(const std::string& path, unsigned int filteringType = GL_NEAREST)
+		{
+			if (workers.empty())
+				StartWorkers();
+
+			Texture* texture = new Texture(1, 1, filteringType);
+			const unsigned char white[4] = { 255, 255, 255, 255 };
+			texture->SetSubImage(0, 0, 1, 1, white);
+			texture->path = path;
+
+			//Numbered so a result for a cancelled texture is never given to a new one at the same address
+			pending[texture] = ++lastTicket;
+			texture->loading = true;
+			waiting.push_back(Request{ texture, lastTicket, path });
+			SubmitWaiting();
+			return texture;
+		}
+
+		//Returns true while texture is still a placeholder
+		bool IsLoading(Texture* texture) const
+		{
+			return pending.count(texture);
+		}
+
+		//How many textures are still loading
+		size_t PendingCount() const
+		{
+			return pending.size();
+		}
+
+		//Stop loading texture, it stays a placeholder
+		void Cancel(Texture* texture)
+		{
+			if (!pending.erase(texture))
+				return;
+			texture->loading = false;
+			if (upload.texture == texture)
+				FinishUpload(false);
+		}
+
+		//Upload decoded images, called every frame by EngineLib::Update
+		//At most uploadBudget bytes are copied to the GPU per frame, larger images are spread over several frames
+		void Update()
+		{
+			SubmitWaiting();
+
+			size_t budget = uploadBudget;
+			while (budget > 0)
+			{
+				//Take the next decoded image
+				if (!upload.texture)
+				{
+					Decoded decoded;
+					if (!results.TryPop(decoded))
+						break;
+					auto it = pending.find(decoded.texture);
+					if (it == pending.end() || it->second != decoded.ticket)
+					{
+						//Cancelled while decoding
+						stbi_image_free(decoded.pixels);
+						continue;
+					}
+					if (!decoded.pixels)
+					{
+						std::cout << "Error loading texture from " << decoded.path << std::endl;
+						pending.erase(decoded.texture);
+						decoded.texture->loading = false;
+						continue;
+					}
+					StartUpload(decoded);
+				}
+
+				//Copy as many whole rows as fit in the budget, always at least one so every image finishes
+				size_t rowSize = (size_t)upload.width * 4;
+				size_t rows = std::clamp(budget / rowSize, (size_t)1, (size_t)(upload.height - upload.rowsCopied));
+				RenderState::Get()->BindBuffer(GL_PIXEL_UNPACK_BUFFER, PBO);
+				glBufferSubData(GL_PIXEL_UNPACK_BUFFER, upload.rowsCopied * rowSize, rows * rowSize, upload.pixels + upload.rowsCopied * rowSize);
+				RenderState::Get()->BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+				upload.rowsCopied += rows;
+				budget -= std::min(budget, rows * rowSize);
+
+				if (upload.rowsCopied == upload.height)
+					FinishUpload(true);
+			}
+		}
+
+		//Bytes copied to the GPU per frame at most
+		size_t uploadBudget = 4 * 1024 * 1024;
+
+	private:
+		struct Request
+		{
+			Texture* texture = nullptr;
+			size_t ticket = 0;
+			std::string path;
+		};
+
+		//A decoded image, bottom row first and always RGBA. pixels is null if decoding failed
+		struct Decoded
+		{
+			Texture* texture = nullptr;
+			size_t ticket = 0;
+			std::string path;
+			unsigned char* pixels = nullptr;
+			int width = 0, height = 0;
+		};
+
+		//The image currently being copied into the pixel buffer
+		struct Upload
+		{
+			Texture* texture = nullptr;
+			unsigned char* pixels = nullptr;
+			int width = 0, height = 0;
+			int rowsCopied = 0;
+		};
+
+		TextureLoader() : requests(256), results(64)
+		{
+			Texture::cancelLoading = [](Texture* texture) { TextureLoader::Get()->Cancel(texture); };
+			glGenBuffers(1, &PBO);
+		}
+
+		void StartWorkers()
+		{
+			//Leave one core for the main thread
+			unsigned int count = std::clamp(std::thread::hardware_concurrency(), 2u, 5u) - 1;
+			for (unsigned int i = 0; i < count; i++)
+			{
+				workers.emplace_back(&TextureLoader::Work, this);
+				//The loader lives for the whole program
+				workers.back().detach();
+			}
+		}
+
+		//Move requests into the worker queue, ones that don't fit wait for the next frame
+		void SubmitWaiting()
+		{
+			while (!waiting.empty())
+			{
+				Request request = waiting.front();
+				if (!requests.TryPush(std::move(request)))
+					break;
+				waiting.pop_front();
+				wakeWorkers.release();
+			}
+		}
+
+		void Work()
+		{
+			//Flip on load only for this thread, the main thread sets the flag for its own loads
+			stbi_set_flip_vertically_on_load_thread(true);
+
+			while (true)
+			{
+				wakeWorkers.acquire();
+
+				Request request;
+				if (!requests.TryPop(request))
+					continue;
+
+				Decoded decoded;
+				decoded.texture = request.texture;
+				decoded.ticket = request.ticket;
+				decoded.path = request.path;
+				int channels;
+				FileView file = FileSystem::Get()->Find(request.path);
+				decoded.pixels = file
+					? stbi_load_from_memory(file.data, (int)file.size, &decoded.width, &decoded.height, &channels, 4)
+					: stbi_load(request.path.c_str(), &decoded.width, &decoded.height, &channels, 4);
+
+				//Wait for the main thread to make room, this keeps the amount of decoded images in memory bounded
+				while (!results.TryPush(std::move(decoded)))
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		}
+
+		void StartUpload(const Decoded& decoded)
+		{
+			upload.texture = decoded.texture;
+			upload.pixels = decoded.pixels;
+			upload.width = decoded.width;
+			upload.height = decoded.height;
+			upload.rowsCopied = 0;
+
+			//Orphan the buffer, the previous upload from it may still be in flight
+			RenderState::Get()->BindBuffer(GL_PIXEL_UNPACK_BUFFER, PBO);
+			glBufferData(GL_PIXEL_UNPACK_BUFFER, (size_t)upload.width * upload.height * 4, nullptr, GL_STREAM_DRAW);
+			RenderState::Get()->BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		}
+
+		//Upload the whole image from the pixel buffer to the texture, the driver can do this without waiting for the copy
+		void FinishUpload(bool uploadTexture)
+		{
+			if (uploadTexture)
+			{
+				RenderState::Get()->BindTexture(upload.texture->id);
+				RenderState::Get()->BindBuffer(GL_PIXEL_UNPACK_BUFFER, PBO);
+				glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+				glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, upload.width, upload.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+				RenderState::Get()->BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+				glGenerateMipmap(GL_TEXTURE_2D);
+				pending.erase(upload.texture);
+				upload.texture->loading = false;
+
+				//Now that the image is loaded it can be evicted and loaded again like any texture loaded from a file
+				upload.texture->sourcePath = upload.texture->path;
+				upload.texture->flip = true;
+				upload.texture->reloadable = true;
+				upload.texture->SetMemorySize((size_t)upload.width * upload.height * 4 * 4 / 3);
+			}
+
+			stbi_image_free(upload.pixels);
+			upload = Upload();
+		}
+
+		BoundedQueue<Request> requests;
+		BoundedQueue<Decoded> results;
+		std::counting_semaphore<> wakeWorkers{ 0 };
+		std::vector<std::thread> workers;
+
+		//Only touched by the main thread
+		std::deque<Request> waiting;
+		std::unordered_map<Texture*, size_t> pending;
+		size_t lastTicket = 0;
+		Upload upload;
+		unsigned int PBO = 0;
+	};
+}
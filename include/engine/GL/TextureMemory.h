@@ -0,0 +1,68 @@
+#pragma once
+#include <unordered_set>
+#include <cstddef>
+#include <cstdint>
+
+namespace engine
+{
+	class Texture;
+
+	//Keeps track of how much GPU memory textures use and keeps it under a budget
+	//When over budget, textures loaded from files which haven't been used for unusedFrames frames are evicted, least recently used first
+	//An evicted texture is loaded again from its file, or the mounted asset pack, the next time it is used
+	//Textures made from pixels in memory, such as atlas pages and tilemap lookups, are counted but never evicted
+	class TextureMemory
+	{
+	public:
+		static TextureMemory* Get()
+		{
+			static TextureMemory* memory = new TextureMemory();
+			return memory;
+		}
+
+		//Start a new frame and evict textures if over budget, called every frame by EngineLib::Update. Defined in Texture.h
+		inline void Update();
+
+		//Print the memory used, the budget and every texture from largest to smallest. Defined in Texture.h
+		inline void PrintReport() const;
+
+		//GPU memory used by every texture currently loaded, in bytes
+		size_t ResidentBytes() const
+		{
+			return residentBytes;
+		}
+
+		//Frames counted by Update, textures remember the frame they were last used on
+		uint64_t Frame() const
+		{
+			return frame;
+		}
+
+		//Bytes of texture memory to stay under
+		size_t budget = 512 * 1024 * 1024;
+		//Textures used within this many frames are never evicted, even when over budget
+		unsigned int unusedFrames = 600;
+
+	private:
+		friend class Texture;
+
+		TextureMemory() {}
+
+		void Register(Texture* texture)
+		{
+			textures.insert(texture);
+		}
+		void Unregister(Texture* texture)
+		{
+			textures.erase(texture);
+		}
+		void Resize(size_t oldBytes, size_t newBytes)
+		{
+			residentBytes = residentBytes - oldBytes + newBytes;
+		}
+
+		std::unordered_set<Texture*> textures;
+		size_t residentBytes = 0;
+		uint64_t frame = 0;
+	};
+}
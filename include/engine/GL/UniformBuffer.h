@@ -0,0 +1,92 @@
+#pragma once
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <engine/GL/Shader.h>
+#include <engine/GL/Camera.h>
+#include <engine/GL/RenderState.h>
+
+namespace engine
+{
+	//Uniform buffer holding the camera's view and projection matrices, shared by every shader with a Camera block
+	//The buffer has two slots, one for the world camera and one with identity matrices for UI elements
+	//so switching between them is only a buffer range bind instead of a matrix upload
+	class CameraUniformBuffer
+	{
+	public:
+		enum class Slot { world = 0, screen = 1 };
+
+		//Get the shared camera buffer. OpenGL must be initialized
+		static CameraUniformBuffer* Get()
+		{
+			static CameraUniformBuffer* buffer = new CameraUniformBuffer();
+			return buffer;
+		}
+
+		//Upload the camera's matrices, does nothing if they have not changed since the last call
+		//Every renderer calls this, so in practice the matrices are uploaded once per frame
+		void Update(Camera* cam)
+		{
+			glm::mat4 newView = cam->GetViewMatrix();
+			glm::mat4 newProjection = cam->GetProjectionMatrix();
+			if (newView == view && newProjection == projection)
+				return;
+
+			view = newView;
+			projection = newProjection;
+			Upload(Slot::world, view, projection);
+		}
+
+		//Give shader the matrices of slot. The shader must be in use
+		//Shaders with the Camera block get the buffer range bound, others get their view and projection uniforms set
+		void Use(Shader* shader, Slot slot = Slot::world)
+		{
+			if (shader->hasCameraBlock)
+			{
+				RenderState::Get()->BindUniformBufferRange(CAMERA_UNIFORM_BINDING, UBO, (int)slot * slotStride, 2 * sizeof(glm::mat4));
+			}
+			else if (slot == Slot::world)
+			{
+				shader->SetMat4("view", view);
+				shader->SetMat4("projection", projection);
+			}
+			else
+			{
+				shader->SetMat4("view", glm::mat4(1.0f));
+				shader->SetMat4("projection", glm::mat4(1.0f));
+			}
+		}
+
+		//The matrices of the last camera given to Update()
+		glm::mat4 view = glm::mat4(0.0f);
+		glm::mat4 projection = glm::mat4(0.0f);
+
+	private:
+		CameraUniformBuffer()
+		{
+			//Each slot must start at a multiple of the offset alignment to be bindable on its own
+			int alignment = 256;
+			glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+			slotStride = ((2 * sizeof(glm::mat4) + alignment - 1) / alignment) * alignment;
+
+			glGenBuffers(1, &UBO);
+			RenderState::Get()->BindBuffer(GL_UNIFORM_BUFFER, UBO);
+			glBufferData(GL_UNIFORM_BUFFER, 2 * slotStride, nullptr, GL_DYNAMIC_DRAW);
+			RenderState::Get()->BindBuffer(GL_UNIFORM_BUFFER, 0);
+
+			//The screen slot never changes
+			Upload(Slot::screen, glm::mat4(1.0f), glm::mat4(1.0f));
+		}
+
+		void Upload(Slot slot, const glm::mat4& newView, const glm::mat4& newProjection)
+		{
+			RenderState::Get()->BindBuffer(GL_UNIFORM_BUFFER, UBO);
+			glBufferSubData(GL_UNIFORM_BUFFER, (int)slot * slotStride, sizeof(glm::mat4), glm::value_ptr(newView));
+			glBufferSubData(GL_UNIFORM_BUFFER, (int)slot * slotStride + sizeof(glm::mat4), sizeof(glm::mat4), glm::value_ptr(newProjection));
+			RenderState::Get()->BindBuffer(GL_UNIFORM_BUFFER, 0);
+		}
+
+		unsigned int UBO = 0;
+		unsigned int slotStride = 0;
+	};
+}
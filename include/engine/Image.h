@@ -1,5 +1,7 @@
 #pragma once
 #include <vector>
+#include <cstring>
+#include <cassert>
 #include <engine/GL/Texture.h>
 
 using namespace std;
@@ -12,152 +14,198 @@ namespace engine
 		unsigned char r, g, b, a;
 	};
 
-	//Image class basically just a 2d vector of rgba values
+	class Image;
+
+	//A rectangle of an image's pixels, without copying them. The image must outlive the view
+	//Coordinates are from the top left like Image's, but the rows are stored bottom row first like OpenGL wants them
+	class ImageView
+	{
+	public:
+		ImageView() {}
+		ImageView(const Pixel* bottomLeft, int width, int height, int stride) : width(width), height(height), stride(stride), bottomLeft(bottomLeft) {}
+		//View the whole image
+		inline ImageView(const Image& image);
+
+		Pixel At(int x, int y) const
+		{
+			return bottomLeft[(height - 1 - y) * stride + x];
+		}
+
+		//A smaller rectangle of this view whose top left corner is at x, y
+		ImageView View(int x, int y, int viewWidth, int viewHeight) const
+		{
+			assert(x >= 0 && y >= 0 && x + viewWidth <= width && y + viewHeight <= height && "View must be in bounds of the original image!");
+			return ImageView(bottomLeft + (height - y - viewHeight) * stride + x, viewWidth, viewHeight, stride);
+		}
+
+		//The bottom left pixel, rows follow each other stride pixels apart
+		const Pixel* Data() const
+		{
+			return bottomLeft;
+		}
+
+		int width = 0;
+		int height = 0;
+		//Pixels from the start of one row to the start of the next
+		int stride = 0;
+
+	private:
+		const Pixel* bottomLeft = nullptr;
+	};
+
+	//Image class, a flat buffer of rgba values
+	//Pixels are accessed from the top left, image[x][y] or At(x, y)
 	class Image
 	{
 	public:
+		//One column of the image, so image[x][y] works without copying anything
+		class Column
+		{
+		public:
+			Column(Pixel* pixels, int x, int width, int height) : pixels(pixels), x(x), width(width), height(height) {}
+
+			Pixel& operator[](int y)
+			{
+				return pixels[(height - 1 - y) * width + x];
+			}
+
+		private:
+			Pixel* pixels;
+			int x, width, height;
+		};
+
 		Image(const char* path)
 		{
-			//Dont flip the image when loading to an Image
-			stbi_set_flip_vertically_on_load(false);
-			//Load image
-			unsigned char* imageData = stbi_load(path, &width, &height, &channels, 4);
+			//Load the image bottom row first, the same way OpenGL stores textures
+			stbi_set_flip_vertically_on_load(true);
+			int channels;
+			FileView file = FileSystem::Get()->Find(path);
+			unsigned char* imageData = file
+				? stbi_load_from_memory(file.data, (int)file.size, &width, &height, &channels, 4)
+				: stbi_load(path, &width, &height, &channels, 4);
 
 			//If the image is loaded successfully
 			if (imageData)
 			{
-				//Resize the pixmap vector to be able to insert just by index
-				pixmap.resize(width);
-				for (size_t i = 0; i < width; i++)
-					pixmap[i].resize(height);
-
-				int i = 0;
-				//For each row and column
-				for (size_t y = 0; y < height; y++)
-				{
-					for (size_t x = 0; x < width; x++)
-					{
-						//Get the rgba values and put them in a nice to use 2D vector of Pixels
-						pixmap[x][y] = Pixel{ imageData[i], imageData[i + 1], imageData[i + 2], imageData[i + 3] };
-						i += 4;
-					}
-				}
+				pixels.resize(width * height);
+				std::memcpy(pixels.data(), imageData, pixels.size() * sizeof(Pixel));
 
 				//Image data is no longer needed
 				stbi_image_free(imageData);
 			}
 			else
 			{
+				width = 0;
+				height = 0;
 				std::cout << "Error loading texture from " << path << std::endl;
 			}
 		}
-		//Construct an image from a 2D vector of pixels
-		Image(vector<vector<Pixel>> pixels)
+		//Construct an image from a 2D vector of pixels, indexed [x][y]
+		Image(vector<vector<Pixel>> pixelColumns)
+		{
+			width = pixelColumns.size();
+			height = pixelColumns[0].size();
+			pixels.resize(width * height);
+			for (int x = 0; x < width; x++)
+				for (int y = 0; y < height; y++)
+					At(x, y) = pixelColumns[x][y];
+		}
+		//Copy the pixels of view into a new image
+		Image(const ImageView& view)
+		{
+			width = view.width;
+			height = view.height;
+			pixels.resize(width * height);
+
+			//Rows are contiguous in both, so copy a whole row at once
+			for (int row = 0; row < height; row++)
+				std::memcpy(&pixels[row * width], view.Data() + row * view.stride, width * sizeof(Pixel));
+		}
+
+		Column operator[](int x)
+		{
+			return Column(pixels.data(), x, width, height);
+		}
+
+		Pixel& At(int x, int y)
+		{
+			return pixels[(height - 1 - y) * width + x];
+		}
+		Pixel GetPixel(int x, int y) const
+		{
+			return pixels[(height - 1 - y) * width + x];
+		}
+
+		//View a rectangle whose top left corner is at x, y without copying it
+		ImageView View(int x, int y, int viewWidth, int viewHeight) const
 		{
-			width = pixels.size();
-			height = pixels[0].size();
-			channels = 4;
-			pixmap = pixels;
+			return ImageView(*this).View(x, y, viewWidth, viewHeight);
 		}
 
-		vector<Pixel> operator[](int i)
+		//The bottom left pixel, rows are stored bottom row first
+		const Pixel* Pixels() const
 		{
-			return pixmap[i];
+			return pixels.data();
 		}
 
-		//Returns the data of this imge in stbimage friendly format
+		//Returns the data of this imge in stbimage friendly format, top row first. The caller must delete[] it
 		unsigned char* data()
 		{
 			unsigned char* data = new unsigned char[width * height * 4];
-			int i = 0;
 			for (int y = 0; y < height; y++)
-			{
-				for (int x = 0; x < width; x++)
-				{
-					data[i++] = pixmap[x][y].r;
-					data[i++] = pixmap[x][y].g;
-					data[i++] = pixmap[x][y].b;
-					data[i++] = pixmap[x][y].a;
-				}
-			}
+				std::memcpy(data + y * width * 4, &pixels[(height - 1 - y) * width], width * sizeof(Pixel));
 			return data;
 		}
 
 		//Get a subsection of pixels from x1 y1 top-left, to x2, y2 bottom-right (inclusive).
+		//This copies the pixels, use View to avoid that
 		Image Slice(int x1, int y1, int x2, int y2)
 		{
 			assert(x1 < x2&& y1 < y2 && "x1 and y1 must be less than x2 and y2!");
 			assert(x1 >= 0 && y1 >= 0 && x2 < width&& y2 < height && "Slice must be in bounds of original image!");
 
-			vector<vector<Pixel>> slice;
-			slice.resize(x2 - x1 + 1);
-			for (size_t i = 0; i < x2 - x1 + 1; i++)
-			{
-				slice[i].resize(y2 - y1 + 1);
-			}
-
-			//For the region defined by parameters
-			int sliceX = 0;
-			for (size_t x = x1; x < x2; x++)
-			{
-				int sliceY = 0;
-				for (size_t y = y1; y < y2; y++)
-				{
-					//Move the pixels from this pixmap to the sliced one
-					slice[sliceX][sliceY] = pixmap[x][y];
-					sliceY++;
-				}
-				sliceX++;
-			}
-
-			return Image(slice);
+			return Image(View(x1, y1, x2 - x1 + 1, y2 - y1 + 1));
 		}
 
-		int width;
-		int height;
+		int width = 0;
+		int height = 0;
 	private:
-		int channels;
-		vector<vector<Pixel>> pixmap;
+		//Bottom row first
+		vector<Pixel> pixels;
 	};
 
-	//Create a texture from an image
+	ImageView::ImageView(const Image& image) : width(image.width), height(image.height), stride(image.width), bottomLeft(image.Pixels()) {}
+
+	//Create a texture from an image or part of one
 	//Declared in Texture.h
-	Texture::Texture(Image image, unsigned int filteringType)
+	Texture::Texture(const ImageView& image, unsigned int filteringType)
 	{
-		//Convert the image to a 1D char array for OpenGL
-		unsigned char* imageData = new unsigned char[image.width * image.height * 4];
-		int i = 0;
-		//Make sure to flip the vertical for OpenGL
-		for (int y = image.height - 1; y >= 0; y--)
-		{
-			for (int x = 0; x < image.width; x++)
-			{
-				imageData[i++] = image[x][y].r;
-				imageData[i++] = image[x][y].g;
-				imageData[i++] = image[x][y].b;
-				imageData[i++] = image[x][y].a;
-			}
-		}
-
 		//Generate and bind texture
 		glGenTextures(1, &id);
-		glBindTexture(GL_TEXTURE_2D, id);
+		RenderState::Get()->BindTexture(id);
 
 		//Set texture filtering parameters
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filteringType);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filteringType);
 
-		//Generate the texture using the image data
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.width, image.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, imageData);
+		//The view's rows are already bottom first, so it can be uploaded straight from the image
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, image.stride);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.width, image.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.Data());
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
 		glGenerateMipmap(GL_TEXTURE_2D);
 
 		//Unbind texture
-		glBindTexture(GL_TEXTURE_2D, 0);
+		RenderState::Get()->BindTexture(0);
+
+		this->filteringType = filteringType;
+		TextureMemory::Get()->Register(this);
+		SetMemorySize((size_t)image.width * image.height * 4 * 4 / 3);
 	}
 
 	//Slice spritesheet image to multiple textures.
 	//spritesWide is how many sprites wide the spritesheet is and spritesHigh is how many sprites tall the spritesheet is
-	vector<Texture*> SliceSpritesheet(const char* path, int spritesWide, int spritesHigh)
+	inline vector<Texture*> SliceSpritesheet(const char* path, int spritesWide, int spritesHigh)
 	{
 		vector<Texture*> slicedTextures;
 
@@ -165,27 +213,17 @@ namespace engine
 		Image spritesheet = Image(path);
 
 		//Get the size of each sprite
-		const int width = floor((spritesheet.width - 1) / spritesWide);
-		const int height = floor((spritesheet.height - 1) / spritesHigh);
+		const int width = spritesheet.width / spritesWide;
+		const int height = spritesheet.height / spritesHigh;
 
 		//Warn if the spritesheet is weirdly sized
 		if (spritesheet.width % spritesWide != 0 || spritesheet.height % spritesHigh != 0)
 			cout << "Spritesheet is not divisible by sprite count. Clipping may occur!";
 
-		//For each sprite to slice out
-		int paddingY = 0;
-		for (size_t row = 0; row < spritesHigh; row++)
-		{
-			int paddingX = 0;
-			for (size_t col = 0; col < spritesWide; col++)
-			{
-				//Get the slice from the spritesheet
-				Image slice = spritesheet.Slice(col * width + paddingX, row * height + paddingY, col * width + width + paddingX, row * height + height + paddingY);
-				slicedTextures.push_back(new Texture(slice));
-				paddingX++;
-			}
-			paddingY++;
-		}
+		//Each sprite is uploaded straight from the spritesheet without copying it out
+		for (int row = 0; row < spritesHigh; row++)
+			for (int col = 0; col < spritesWide; col++)
+				slicedTextures.push_back(new Texture(spritesheet.View(col * width, row * height, width, height)));
 
 		return slicedTextures;
 	}
@@ -193,7 +231,7 @@ namespace engine
 	//Creates animations from a spritesheet.
 	//Each row of sprites on the spritesheet becomes one animation. 
 	//You must provide a vector of delays for each frame going from top-left to bottom-right
-	vector<Animation> AnimationsFromSpritesheet(const char* path, int spritesWide, int spritesHigh, vector<int> delays)
+	inline vector<Animation> AnimationsFromSpritesheet(const char* path, int spritesWide, int spritesHigh, vector<int> delays)
 	{
 		vector<Texture*> allFrames = SliceSpritesheet(path, spritesWide, spritesHigh);
 
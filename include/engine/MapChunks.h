@@ -0,0 +1,345 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <tmxlite/TileLayer.hpp>
+#include <engine/FileSystem.h>
+
+namespace engine
+{
+	//A tile map split into chunks by the MapChunker tool, so maps too large to load at once can be streamed
+	//The map becomes a manifest, name.tmap, describing the map, and name_x_y.chunk files next to it holding the tiles of one chunk each
+	//Chunks without any tiles don't get a file
+	class MapManifest
+	{
+	public:
+		struct Tileset
+		{
+			uint32_t firstGID = 0;
+			uint32_t tileCount = 0;
+			uint32_t columns = 0;
+			uint32_t tileWidth = 0;
+			uint32_t tileHeight = 0;
+			//The tileset image relative to the manifest's directory
+			std::string imagePath;
+		};
+
+		struct Layer
+		{
+			std::string name;
+			float z = 0;
+			//The layer named "collider", used for tile collision instead of drawn
+			bool collider = false;
+		};
+
+		//Read the manifest at path, from a mounted asset pack if it has it. Returns false if it can't be read
+		bool Read(const std::string& path)
+		{
+			std::string data;
+			if (!ReadFile(path, data))
+				return false;
+
+			Reader reader{ data };
+			char magic[4];
+			uint32_t version = 0, tilesetCount = 0, layerCount = 0;
+			reader.Bytes(magic, 4);
+			reader.Value(version);
+			if (std::memcmp(magic, MAGIC, 4) != 0 || version != VERSION)
+				return false;
+
+			reader.Value(width);
+			reader.Value(height);
+			reader.Value(tileWidth);
+			reader.Value(tileHeight);
+			reader.Value(chunkSize);
+			reader.Value(left);
+			reader.Value(top);
+			//A corrupt manifest must not divide by zero or make huge allocations
+			if (!reader.ok || chunkSize == 0 || tileWidth == 0 || tileHeight == 0)
+				return false;
+
+			//Counts are checked against the bytes left before anything is allocated for them
+			reader.Value(tilesetCount);
+			if (!reader.Fits(tilesetCount, TILESET_MIN_SIZE))
+				return false;
+			tilesets.resize(tilesetCount);
+			for (Tileset& tileset : tilesets)
+			{
+				reader.Value(tileset.firstGID);
+				reader.Value(tileset.tileCount);
+				reader.Value(tileset.columns);
+				reader.Value(tileset.tileWidth);
+				reader.Value(tileset.tileHeight);
+				tileset.imagePath = reader.String();
+			}
+
+			reader.Value(layerCount);
+			if (!reader.Fits(layerCount, LAYER_MIN_SIZE))
+				return false;
+			layers.resize(layerCount);
+			for (Layer& layer : layers)
+			{
+				layer.name = reader.String();
+				reader.Value(layer.z);
+				uint32_t collider = 0;
+				reader.Value(collider);
+				layer.collider = collider;
+			}
+
+			//One byte per chunk is all that is left
+			uint64_t chunkCount = (uint64_t)ChunksWide() * ChunksHigh();
+			if (!reader.ok || chunkCount != reader.data.size() - reader.position)
+				return false;
+			chunks.resize(chunkCount);
+			reader.Bytes(chunks.data(), chunks.size());
+			return reader.ok;
+		}
+
+		bool Write(const std::string& path) const
+		{
+			std::ofstream file(path, std::ios::binary);
+			if (!file)
+				return false;
+
+			Writer writer{ file };
+			writer.Bytes(MAGIC, 4);
+			writer.Value(VERSION);
+			writer.Value(width);
+			writer.Value(height);
+			writer.Value(tileWidth);
+			writer.Value(tileHeight);
+			writer.Value(chunkSize);
+			writer.Value(left);
+			writer.Value(top);
+
+			writer.Value((uint32_t)tilesets.size());
+			for (const Tileset& tileset : tilesets)
+			{
+				writer.Value(tileset.firstGID);
+				writer.Value(tileset.tileCount);
+				writer.Value(tileset.columns);
+				writer.Value(tileset.tileWidth);
+				writer.Value(tileset.tileHeight);
+				writer.String(tileset.imagePath);
+			}
+
+			writer.Value((uint32_t)layers.size());
+			for (const Layer& layer : layers)
+			{
+				writer.String(layer.name);
+				writer.Value(layer.z);
+				writer.Value((uint32_t)layer.collider);
+			}
+
+			writer.Bytes(chunks.data(), chunks.size());
+			return (bool)file;
+		}
+
+		uint32_t ChunksWide() const
+		{
+			return (uint32_t)(((uint64_t)width + chunkSize - 1) / chunkSize);
+		}
+		uint32_t ChunksHigh() const
+		{
+			return (uint32_t)(((uint64_t)height + chunkSize - 1) / chunkSize);
+		}
+
+		//Does the chunk at x, y have a file
+		bool HasChunk(int x, int y) const
+		{
+			return x >= 0 && y >= 0 && x < (int)ChunksWide() && y < (int)ChunksHigh() && chunks[(size_t)y * ChunksWide() + x];
+		}
+
+		//The file of the chunk at x, y of the map whose manifest is at manifestPath
+		static std::string ChunkPath(const std::string& manifestPath, int x, int y)
+		{
+			std::filesystem::path path(manifestPath);
+			path.replace_extension();
+			return path.generic_string() + "_" + std::to_string(x) + "_" + std::to_string(y) + ".chunk";
+		}
+
+		//Map size in tiles, and tile size in pixels
+		uint32_t width = 0, height = 0;
+		uint32_t tileWidth = 0, tileHeight = 0;
+		//Width and height of a chunk in tiles
+		uint32_t chunkSize = 32;
+		//Top left corner of the map
+		float left = 0, top = 0;
+
+		std::vector<Tileset> tilesets;
+		std::vector<Layer> layers;
+		//1 for every chunk with a file, row by row
+		std::vector<uint8_t> chunks;
+
+		static constexpr char MAGIC[4] = { 'T', 'M', 'A', 'P' };
+		static constexpr uint32_t VERSION = 1;
+		//Bytes of a tileset and a layer with empty strings
+		static constexpr size_t TILESET_MIN_SIZE = 6 * sizeof(uint32_t);
+		static constexpr size_t LAYER_MIN_SIZE = sizeof(uint32_t) + sizeof(float) + sizeof(uint32_t);
+
+		//Read a whole file into data, from a mounted asset pack if it has it. Shared with MapChunkFile
+		static bool ReadFile(const std::string& path, std::string& data)
+		{
+			FileView view = FileSystem::Get()->Find(path);
+			if (view)
+			{
+				data.assign((const char*)view.data, view.size);
+				return true;
+			}
+
+			std::ifstream file(path, std::ios::binary);
+			if (!file)
+				return false;
+			std::stringstream contents;
+			contents << file.rdbuf();
+			data = contents.str();
+			return true;
+		}
+
+		//Reads values from a file in memory, ok turns false if it tries to read past the end
+		struct Reader
+		{
+			const std::string& data;
+			size_t position = 0;
+			bool ok = true;
+
+			void Bytes(void* destination, size_t size)
+			{
+				if (!ok || position + size > data.size())
+				{
+					ok = false;
+					return;
+				}
+				std::memcpy(destination, data.data() + position, size);
+				position += size;
+			}
+			//Are there at least count items of size bytes left
+			bool Fits(uint64_t count, size_t size) const
+			{
+				return ok && count <= (data.size() - position) / size;
+			}
+			template<typename T>
+			void Value(T& value)
+			{
+				Bytes(&value, sizeof(T));
+			}
+			std::string String()
+			{
+				uint32_t length = 0;
+				Value(length);
+				if (!ok || position + length > data.size())
+				{
+					ok = false;
+					return "";
+				}
+				std::string string = data.substr(position, length);
+				position += length;
+				return string;
+			}
+		};
+
+		struct Writer
+		{
+			std::ofstream& file;
+
+			void Bytes(const void* source, size_t size)
+			{
+				file.write((const char*)source, size);
+			}
+			template<typename T>
+			void Value(const T& value)
+			{
+				Bytes(&value, sizeof(T));
+			}
+			void String(const std::string& string)
+			{
+				Value((uint32_t)string.size());
+				Bytes(string.data(), string.size());
+			}
+		};
+	};
+
+	//The tiles of every layer in one chunk of a map split by MapChunker
+	class MapChunkFile
+	{
+	public:
+		bool Read(const std::string& path)
+		{
+			std::string data;
+			if (!MapManifest::ReadFile(path, data))
+				return false;
+
+			MapManifest::Reader reader{ data };
+			char magic[4];
+			uint32_t version = 0, layerCount = 0;
+			reader.Bytes(magic, 4);
+			reader.Value(version);
+			if (std::memcmp(magic, MAGIC, 4) != 0 || version != MapManifest::VERSION)
+				return false;
+
+			reader.Value(x);
+			reader.Value(y);
+			reader.Value(width);
+			reader.Value(height);
+			reader.Value(layerCount);
+
+			//Every tile of every layer is in the file, so a corrupt size can be caught before allocating
+			uint64_t tileCount = (uint64_t)width * height * layerCount;
+			if (!reader.ok || width == 0 || height == 0 || !reader.Fits(tileCount, TILE_SIZE) || tileCount * TILE_SIZE != reader.data.size() - reader.position)
+				return false;
+
+			layers.resize(layerCount);
+			for (std::vector<tmx::TileLayer::Tile>& tiles : layers)
+			{
+				tiles.resize((size_t)width * height);
+				for (tmx::TileLayer::Tile& tile : tiles)
+				{
+					uint32_t flipFlags = 0;
+					reader.Value(tile.ID);
+					reader.Value(flipFlags);
+					tile.flipFlags = (std::uint8_t)flipFlags;
+				}
+			}
+			return reader.ok;
+		}
+
+		bool Write(const std::string& path) const
+		{
+			std::ofstream file(path, std::ios::binary);
+			if (!file)
+				return false;
+
+			MapManifest::Writer writer{ file };
+			writer.Bytes(MAGIC, 4);
+			writer.Value(MapManifest::VERSION);
+			writer.Value(x);
+			writer.Value(y);
+			writer.Value(width);
+			writer.Value(height);
+			writer.Value((uint32_t)layers.size());
+			for (const std::vector<tmx::TileLayer::Tile>& tiles : layers)
+			{
+				for (const tmx::TileLayer::Tile& tile : tiles)
+				{
+					writer.Value(tile.ID);
+					writer.Value((uint32_t)tile.flipFlags);
+				}
+			}
+			return (bool)file;
+		}
+
+		//Chunk coordinates, and size in tiles which is smaller than the chunk size on the right and bottom edges of the map
+		uint32_t x = 0, y = 0;
+		uint32_t width = 0, height = 0;
+		//Tiles of each layer in the manifest's order, row by row
+		std::vector<std::vector<tmx::TileLayer::Tile>> layers;
+
+		static constexpr char MAGIC[4] = { 'T', 'C', 'H', 'K' };
+		//ID and flip flags
+		static constexpr size_t TILE_SIZE = 2 * sizeof(uint32_t);
+	};
+}
@@ -30,36 +30,97 @@ source distribution.
 #include <vector>
 #include <memory>
 #include <engine/GL/Texture.h>
+#include <engine/GL/Frustum.h>
 #include <tmxlite/Map.hpp>
+#include <tmxlite/TileLayer.hpp>
 
+//A tile layer split into square chunks of tiles, each with its own quad and lookup textures
+//Only the chunks the camera can see are drawn, so the size of the map doesn't matter, only how much of it is on screen
 class MapLayer final
 {
 public:
+	//Width and height of a chunk in tiles
+	static const unsigned int CHUNK_SIZE = 32;
+
+	//Which tile IDs belong to a tileset and how it is laid out
+	struct TilesetRange final
+	{
+		std::uint32_t firstGID;
+		std::uint32_t tileCount;
+		std::uint32_t columns;
+	};
+
+	//The lookup texture data of one chunk for one tileset, built without OpenGL so it can be done on a worker thread
+	struct ChunkLookup final
+	{
+		std::size_t tileset;
+		std::vector<std::uint16_t> pixelData;
+	};
+
 	MapLayer(const tmx::Map&, std::size_t, const std::vector <std::shared_ptr<engine::Texture>>& textures);
+	//An empty layer for streaming, chunks are added as they are loaded
+	MapLayer(const std::vector <std::shared_ptr<engine::Texture>>& textures);
 	~MapLayer();
 	
 	MapLayer(const MapLayer&) = delete;
 	MapLayer& operator = (const MapLayer&) = delete;
 	
-	void draw(glm::mat4 model, unsigned int modelLoc, unsigned int, unsigned int);
+	//Draw the chunks of the layer inside frustum
+	void draw(glm::mat4 model, unsigned int modelLoc, unsigned int, unsigned int, const engine::Frustum& frustum);
+
+	//Build the lookup data of a width by height chunk whose first tile is tiles[0], rows are rowStride tiles apart
+	//Tilesets the chunk doesn't use are left out, so an empty chunk has no lookups
+	static std::vector<ChunkLookup> buildLookups(const tmx::TileLayer::Tile* tiles, std::size_t rowStride, unsigned int width, unsigned int height, const std::vector<TilesetRange>& tilesets);
+
+	//Add a chunk covering left, top to right, bottom before the layer's transform, key identifies it for removeChunk
+	void addChunk(std::uint64_t key, glm::vec4 rect, unsigned int width, unsigned int height, const std::vector<ChunkLookup>& lookups, const std::vector<TilesetRange>& tilesets);
+	void removeChunk(std::uint64_t key);
+
+	//Chunks with at least one tile in them, empty chunks aren't kept
+	std::size_t chunkCount() const
+	{
+		return m_chunks.size();
+	}
 
 	float zLayer = 0;
 	glm::vec2 tileSize;
+	//How many chunks the last draw drew
+	unsigned int visibleChunks = 0;
 private:
 	std::vector < std::shared_ptr<engine::Texture> > m_allTextures;
 
-	unsigned int VAO;
+	//The quads of every chunk are in one vertex buffer, four vertices each in the chunk's slot
+	unsigned int VAO = 0;
+	unsigned int VBO = 0;
+	//A copy of the vertex buffer, to upload again when it has to grow
+	std::vector<float> m_verts;
+	//Floats the vertex buffer has room for
+	std::size_t m_bufferFloats = 0;
+	//Slots of removed chunks, reused by the next chunks added
+	std::vector<std::size_t> m_freeSlots;
+	//Set while createChunks adds chunks, it uploads the vertex buffer once at the end
+	bool m_deferUpload = false;
 	//unsigned int tileSize;
 
 	struct Subset final
 	{
 		float sx;
 		float sy;
-		unsigned vbo = 0;
 		std::shared_ptr<engine::Texture> texture = 0;
 		std::shared_ptr<engine::Texture> lookup = 0;
 	};
-	std::vector<Subset> m_subsets;
 
-	void createSubsets(const tmx::Map&, std::size_t);
+	struct Chunk final
+	{
+		std::uint64_t key;
+		std::size_t slot;
+		//The chunk's quad before the layer's transform
+		engine::AABB bounds;
+		//Only the tilesets the chunk uses, each lookup texture covers just the chunk
+		std::vector<Subset> subsets;
+	};
+	std::vector<Chunk> m_chunks;
+
+	void createVertexArray();
+	void createChunks(const tmx::Map&, std::size_t);
 };
\ No newline at end of file
@@ -0,0 +1,131 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace engine
+{
+	//A read only view of a whole file mapped into memory
+	//The pages are only read from disk when touched, so nothing is copied into an intermediate buffer
+	class MappedFile
+	{
+	public:
+		MappedFile() {}
+		MappedFile(const std::string& path)
+		{
+			Open(path);
+		}
+		~MappedFile()
+		{
+			Close();
+		}
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		//Map the file at path, returns false if it can't be opened. Any previously mapped file is closed
+		bool Open(const std::string& path)
+		{
+			Close();
+
+#ifdef _WIN32
+			file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			if (file == INVALID_HANDLE_VALUE)
+				return false;
+
+			LARGE_INTEGER fileSize;
+			if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+			{
+				Close();
+				return false;
+			}
+			size = (size_t)fileSize.QuadPart;
+
+			mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (!mapping)
+			{
+				Close();
+				return false;
+			}
+			data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+			int fd = open(path.c_str(), O_RDONLY);
+			if (fd < 0)
+				return false;
+
+			struct stat info;
+			if (fstat(fd, &info) != 0 || info.st_size == 0)
+			{
+				close(fd);
+				return false;
+			}
+			size = (size_t)info.st_size;
+
+			//The mapping stays valid after the descriptor is closed
+			void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			close(fd);
+			if (mapped != MAP_FAILED)
+				data = (const unsigned char*)mapped;
+#endif
+
+			if (!data)
+			{
+				Close();
+				return false;
+			}
+			return true;
+		}
+
+		void Close()
+		{
+#ifdef _WIN32
+			if (data)
+				UnmapViewOfFile(data);
+			if (mapping)
+				CloseHandle(mapping);
+			if (file != INVALID_HANDLE_VALUE)
+				CloseHandle(file);
+			mapping = nullptr;
+			file = INVALID_HANDLE_VALUE;
+#else
+			if (data)
+				munmap((void*)data, size);
+#endif
+			data = nullptr;
+			size = 0;
+		}
+
+		bool IsOpen() const
+		{
+			return data != nullptr;
+		}
+
+		const unsigned char* Data() const
+		{
+			return data;
+		}
+		size_t Size() const
+		{
+			return size;
+		}
+
+	private:
+		const unsigned char* data = nullptr;
+		size_t size = 0;
+#ifdef _WIN32
+		HANDLE file = INVALID_HANDLE_VALUE;
+		HANDLE mapping = nullptr;
+#endif
+	};
+}
@@ -0,0 +1,335 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <engine/ModelData.h>
+
+namespace engine
+{
+	//Makes imported meshes smaller and faster to draw:
+	//identical vertices are welded, triangles are ordered for the GPU's post transform vertex cache,
+	//vertices are reordered to be fetched in the order they are used, and normals can be packed
+	//Indices become 16-bit when uploaded if the welded mesh has few enough vertices
+	class MeshOptimizer
+	{
+	public:
+		struct Options
+		{
+			//Weld identical vertices
+			bool deduplicate = true;
+			//Reorder triangles for the vertex cache and vertices for fetching
+			bool reorder = true;
+			//Pack normals into 10 bits per axis, 8 bytes less per vertex
+			bool packNormals = false;
+		};
+
+		//What the optimizer did, summed over every mesh given to Optimize
+		struct Report
+		{
+			size_t verticesBefore = 0;
+			size_t verticesAfter = 0;
+			size_t bytesBefore = 0;
+			size_t bytesAfter = 0;
+			//Average cache miss ratio, transformed vertices per triangle with a simulated 16 entry FIFO cache. Lower is better, 0.5 is the ideal
+			double acmrBefore = 0;
+			double acmrAfter = 0;
+			size_t triangles = 0;
+
+			size_t BytesSaved() const
+			{
+				return bytesBefore > bytesAfter ? bytesBefore - bytesAfter : 0;
+			}
+		};
+
+		//Optimize mesh in place with the default options
+		static void Optimize(MeshData& mesh)
+		{
+			Optimize(mesh, Options(), nullptr);
+		}
+		//Optimize mesh in place, report is added to if not null
+		static void Optimize(MeshData& mesh, const Options& options, Report* report)
+		{
+			size_t triangles = mesh.indices.size() / 3;
+			size_t verticesBefore = mesh.vertices.size();
+			//Before optimizing, every mesh was uploaded with full vertices and 32-bit indices
+			size_t bytesBefore = mesh.vertices.size() * sizeof(Mesh::Vertex) + mesh.indices.size() * sizeof(uint32_t);
+			double missesBefore = CacheMisses(mesh.indices);
+
+			if (options.deduplicate)
+				Deduplicate(mesh);
+			if (options.reorder)
+			{
+				OptimizeVertexCache(mesh.indices, mesh.vertices.size());
+				OptimizeVertexFetch(mesh);
+			}
+			if (options.packNormals)
+				mesh.vertexFormat = Mesh::VertexFormat::packedNormals;
+
+			if (report)
+			{
+				//Keep the miss ratios weighted by triangle count so the report covers the whole model
+				double total = (double)(report->triangles + triangles);
+				if (total > 0)
+				{
+					report->acmrBefore = (report->acmrBefore * report->triangles + missesBefore * triangles) / total;
+					report->acmrAfter = (report->acmrAfter * report->triangles + CacheMisses(mesh.indices) * triangles) / total;
+				}
+				report->triangles += triangles;
+				report->verticesBefore += verticesBefore;
+				report->verticesAfter += mesh.vertices.size();
+				report->bytesBefore += bytesBefore;
+				report->bytesAfter += GPUSize(mesh);
+			}
+		}
+
+		//Weld vertices which are exactly the same and remap the indices to them
+		static void Deduplicate(MeshData& mesh)
+		{
+			std::unordered_map<uint64_t, std::vector<unsigned int>> buckets;
+			buckets.reserve(mesh.vertices.size());
+			std::vector<unsigned int> remap(mesh.vertices.size());
+			std::vector<Mesh::Vertex> unique;
+			unique.reserve(mesh.vertices.size());
+
+			for (size_t i = 0; i < mesh.vertices.size(); i++)
+			{
+				const Mesh::Vertex& vertex = mesh.vertices[i];
+				std::vector<unsigned int>& bucket = buckets[Hash(vertex)];
+
+				//Compare against every vertex with the same hash
+				auto match = std::find_if(bucket.begin(), bucket.end(), [&](unsigned int index)
+					{
+						return std::memcmp(&unique[index], &vertex, sizeof(Mesh::Vertex)) == 0;
+					});
+
+				if (match != bucket.end())
+				{
+					remap[i] = *match;
+				}
+				else
+				{
+					remap[i] = unique.size();
+					bucket.push_back(unique.size());
+					unique.push_back(vertex);
+				}
+			}
+
+			for (unsigned int& index : mesh.indices)
+				index = remap[index];
+			mesh.vertices.swap(unique);
+		}
+
+		//Tom Forsyth's linear speed vertex cache optimization
+		//Greedily emits the triangle with the highest score, where vertices recently used and vertices with few triangles left score highest
+		static void OptimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount)
+		{
+			size_t triangleCount = indices.size() / 3;
+			if (triangleCount < 2)
+				return;
+
+			//Triangles using each vertex, as ranges into one array
+			std::vector<unsigned int> remaining(vertexCount, 0);
+			for (unsigned int index : indices)
+				remaining[index]++;
+
+			std::vector<unsigned int> firstTriangle(vertexCount + 1, 0);
+			for (size_t i = 0; i < vertexCount; i++)
+				firstTriangle[i + 1] = firstTriangle[i] + remaining[i];
+
+			std::vector<unsigned int> vertexTriangles(indices.size());
+			std::vector<unsigned int> fill(firstTriangle.begin(), firstTriangle.end() - 1);
+			for (size_t i = 0; i < indices.size(); i++)
+				vertexTriangles[fill[indices[i]]++] = i / 3;
+
+			std::vector<int> cachePosition(vertexCount, -1);
+			std::vector<float> vertexScores(vertexCount);
+			for (size_t i = 0; i < vertexCount; i++)
+				vertexScores[i] = VertexScore(-1, remaining[i]);
+
+			std::vector<float> triangleScores(triangleCount);
+			std::vector<bool> emitted(triangleCount, false);
+			for (size_t i = 0; i < triangleCount; i++)
+				triangleScores[i] = vertexScores[indices[i * 3]] + vertexScores[indices[i * 3 + 1]] + vertexScores[indices[i * 3 + 2]];
+
+			std::vector<unsigned int> result;
+			result.reserve(indices.size());
+			std::vector<unsigned int> cache, newCache;
+			cache.reserve(CACHE_SIZE + 3);
+			newCache.reserve(CACHE_SIZE + 3);
+
+			size_t bestTriangle = std::max_element(triangleScores.begin(), triangleScores.end()) - triangleScores.begin();
+			size_t scanStart = 0;
+
+			while (true)
+			{
+				//Nothing in the cache has triangles left, continue from the best remaining triangle anywhere
+				if (bestTriangle == NONE)
+				{
+					float bestScore = -std::numeric_limits<float>::max();
+					while (scanStart < triangleCount && emitted[scanStart])
+						scanStart++;
+					if (scanStart == triangleCount)
+						break;
+
+					for (size_t i = scanStart; i < triangleCount; i++)
+					{
+						if (!emitted[i] && triangleScores[i] > bestScore)
+						{
+							bestScore = triangleScores[i];
+							bestTriangle = i;
+						}
+					}
+				}
+
+				//Emit the triangle and take it out of its vertices' triangle lists
+				emitted[bestTriangle] = true;
+				const unsigned int* triangle = &indices[bestTriangle * 3];
+				newCache.clear();
+				for (int i = 0; i < 3; i++)
+				{
+					unsigned int vertex = triangle[i];
+					result.push_back(vertex);
+					//Degenerate triangles use the same vertex more than once
+					if (std::find(newCache.begin(), newCache.end(), vertex) == newCache.end())
+						newCache.push_back(vertex);
+
+					unsigned int* begin = &vertexTriangles[firstTriangle[vertex]];
+					unsigned int* end = begin + remaining[vertex];
+					unsigned int* found = std::find(begin, end, (unsigned int)bestTriangle);
+					*found = *(end - 1);
+					remaining[vertex]--;
+				}
+
+				//The emitted vertices move to the front of the cache, everything else shifts back
+				for (unsigned int vertex : cache)
+				{
+					if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+						newCache.push_back(vertex);
+				}
+				for (size_t i = CACHE_SIZE; i < newCache.size(); i++)
+				{
+					cachePosition[newCache[i]] = -1;
+					vertexScores[newCache[i]] = VertexScore(-1, remaining[newCache[i]]);
+				}
+				newCache.resize(std::min(newCache.size(), (size_t)CACHE_SIZE));
+				cache.swap(newCache);
+
+				for (size_t i = 0; i < cache.size(); i++)
+				{
+					cachePosition[cache[i]] = i;
+					vertexScores[cache[i]] = VertexScore(i, remaining[cache[i]]);
+				}
+
+				//Only triangles of vertices in the cache changed score, pick the best of them next
+				bestTriangle = NONE;
+				float bestScore = -std::numeric_limits<float>::max();
+				for (unsigned int vertex : cache)
+				{
+					for (unsigned int i = 0; i < remaining[vertex]; i++)
+					{
+						unsigned int t = vertexTriangles[firstTriangle[vertex] + i];
+						float score = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+						triangleScores[t] = score;
+						if (score > bestScore)
+						{
+							bestScore = score;
+							bestTriangle = t;
+						}
+					}
+				}
+			}
+
+			indices.swap(result);
+		}
+
+		//Renumber vertices in the order the indices first use them, so vertex fetches walk through memory linearly
+		//Vertices no index uses are dropped
+		static void OptimizeVertexFetch(MeshData& mesh)
+		{
+			const unsigned int unused = std::numeric_limits<unsigned int>::max();
+			std::vector<unsigned int> remap(mesh.vertices.size(), unused);
+			std::vector<Mesh::Vertex> ordered;
+			ordered.reserve(mesh.vertices.size());
+
+			for (unsigned int& index : mesh.indices)
+			{
+				if (remap[index] == unused)
+				{
+					remap[index] = ordered.size();
+					ordered.push_back(mesh.vertices[index]);
+				}
+				index = remap[index];
+			}
+			mesh.vertices.swap(ordered);
+		}
+
+		//Bytes the mesh takes on the GPU
+		static size_t GPUSize(const MeshData& mesh)
+		{
+			return mesh.vertices.size() * Mesh::VertexSize(mesh.vertexFormat) + mesh.indices.size() * Mesh::IndexSize(Mesh::IndexTypeFor(mesh.vertices.size()));
+		}
+
+		//Transformed vertices per triangle with a simulated FIFO cache
+		static double CacheMisses(const std::vector<unsigned int>& indices, size_t cacheSize = 16)
+		{
+			if (indices.size() < 3)
+				return 0;
+
+			std::vector<unsigned int> fifo;
+			size_t misses = 0;
+			for (unsigned int index : indices)
+			{
+				if (std::find(fifo.begin(), fifo.end(), index) != fifo.end())
+					continue;
+
+				misses++;
+				fifo.push_back(index);
+				if (fifo.size() > cacheSize)
+					fifo.erase(fifo.begin());
+			}
+			return (double)misses / (indices.size() / 3);
+		}
+
+	private:
+		static const int CACHE_SIZE = 32;
+		static const size_t NONE = std::numeric_limits<size_t>::max();
+
+		static float VertexScore(int cachePosition, unsigned int remainingTriangles)
+		{
+			//Vertices without triangles left are never wanted
+			if (remainingTriangles == 0)
+				return -1;
+
+			float score = 0;
+			if (cachePosition >= 0)
+			{
+				//The last triangle's vertices get a fixed score so its neighbours aren't preferred too strongly
+				if (cachePosition < 3)
+					score = 0.75f;
+				else
+					score = std::pow(1.0f - (float)(cachePosition - 3) / (CACHE_SIZE - 3), 1.5f);
+			}
+
+			//Finish off vertices with only a few triangles left so they don't need to be loaded again later
+			score += 2.0f * std::pow((float)remainingTriangles, -0.5f);
+			return score;
+		}
+
+		//FNV-1a over the vertex's bytes
+		static uint64_t Hash(const Mesh::Vertex& vertex)
+		{
+			const unsigned char* bytes = (const unsigned char*)&vertex;
+			uint64_t hash = 14695981039346656037ull;
+			for (size_t i = 0; i < sizeof(Mesh::Vertex); i++)
+			{
+				hash ^= bytes[i];
+				hash *= 1099511628211ull;
+			}
+			return hash;
+		}
+	};
+}
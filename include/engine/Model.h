@@ -7,6 +7,8 @@
 //STL 
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <cstddef>
 
 //Engine
 #include <engine/ECSCore.h>
@@ -15,6 +17,12 @@
 #include <engine/GL/Texture.h>
 #include <engine/GL/Camera.h>
 #include <engine/GL/Mesh.h>
+#include <engine/CookedModel.h>
+#include <engine/MeshOptimizer.h>
+#include <engine/GL/UniformBuffer.h>
+#include <engine/AssetManager.h>
+#include <engine/SpatialGrid.h>
+#include <glm/gtc/matrix_inverse.hpp>
 
 extern ECS ecs;
 
@@ -24,31 +32,39 @@ namespace engine
 	class Model
 	{
 	public:
-		Model(const char* path)
+		//Load a model from path, either anything Assimp supports or a cooked model made by the ModelCooker tool
+		//Models imported with Assimp are optimized with options, cooked models were already optimized when cooking
+		//The vertices and indices are only kept in memory after uploading if keepMeshData is true, for example for collision or picking
+		Model(const char* path, const MeshOptimizer::Options& options = MeshOptimizer::Options(), bool keepMeshData = false)
 		{
-			LoadModel(path);
-		}
-		~Model()
-		{
-			for (Texture* tex : textures_loaded)
-			{
-				delete tex;
-			}
+			LoadModel(path, options, keepMeshData);
 		}
+		//The model owns its meshes and holds references to its textures, which are shared through the AssetManager
+		Model(const Model&) = delete;
+		Model& operator=(const Model&) = delete;
 
 		//Model data
 		std::vector<Mesh> meshes;
+		//Local space bounds of every mesh
+		AABB bounds;
+
+		//Import a model with Assimp into CPU side data without touching OpenGL, used by the model cooker
+		//Every mesh is optimized with options, and what the optimizer did is added to report if given
+		static bool Import(const std::string& path, ModelData& model, const MeshOptimizer::Options& options = MeshOptimizer::Options(), MeshOptimizer::Report* report = nullptr);
 
 	private:
-		void LoadModel(std::string path);
-		void ProcessNode(aiNode* node, const aiScene* scene);
-		Mesh ProcessMesh(aiMesh* mesh, const aiScene* scene);
-		std::vector<Texture*> LoadMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName);
+		void LoadModel(std::string path, const MeshOptimizer::Options& options, bool keepMeshData);
+		void LoadCooked(const std::string& path, bool keepMeshData);
+		static void ProcessNode(aiNode* node, const aiScene* scene, ModelData& model);
+		static MeshData ProcessMesh(aiMesh* mesh, const aiScene* scene);
+		static void GetMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName, std::vector<MaterialTexture>& textures);
+		std::vector<Texture*> LoadTextures(const std::vector<MaterialTexture>& materialTextures);
+		static std::vector<std::string> TextureTypes(const std::vector<MaterialTexture>& materialTextures);
 
 		//Model file path
 		std::string directory;
-		//Store all the already loaded textures for efficiency
-		std::vector<Texture*> textures_loaded;
+		//Keeps the model's textures loaded
+		std::vector<AssetHandle<Texture>> textures_loaded;
 	};
 
 	//3D Model Renderer component
@@ -78,17 +94,22 @@ namespace engine
                 out vec2 TexCoords;
 
 
-				uniform mat4 model;
-				uniform mat4 view;
-				uniform mat4 projection;
+				//Per instance model and normal matrices
+				layout(location = 3) in mat4 instanceModel;
+				layout(location = 7) in mat3 instanceNormal;
+				layout(std140) uniform Camera
+				{
+					mat4 view;
+					mat4 projection;
+				};
 
 				void main()
 				{
 					TexCoords = aTexCoords;
-                    FragPos = vec3 (model * vec4(aPos,1.0));
-                    Normal = mat3(transpose(inverse(model))) *aNormal;
+                    FragPos = vec3 (instanceModel * vec4(aPos,1.0));
+                    Normal = instanceNormal * aNormal;
  
-					gl_Position = projection * view * model * vec4(aPos, 1.0);
+					gl_Position = projection * view * vec4(FragPos, 1.0);
                     
 				}
 				)",
@@ -134,103 +155,220 @@ namespace engine
 				)", false);
 			
 		}
+		~ModelRenderSystem()
+		{
+			if (instanceVBO)
+			{
+				RenderState::Get()->DeleteBuffer(instanceVBO);
+				glDeleteBuffers(1, &instanceVBO);
+			}
+		}
 
 		void Update(Camera* cam)
 		{
-			//For each entity
-			for (const Entity& entity : entities)
-			{
-				//Get relevant components
-				Transform& transform = ecs.getComponent<Transform>(entity);
-				ModelRenderer& modelRenderer = ecs.getComponent<ModelRenderer>(entity);
+			//Upload the camera matrices for every shader at once
+			CameraUniformBuffer* cameraBuffer = CameraUniformBuffer::Get();
+			cameraBuffer->Update(cam);
 
-				//If a shader has been specified for this sprite use it, else use the default
-				Shader* shader = defaultShader;
-				if (modelRenderer.shader)
-					shader = modelRenderer.shader;
-				shader->use();
-
-				//Create the model matrix, this is the same for each mesh so it only needs to be done once
-				glm::mat4 model = glm::mat4(1.0f);
-				//Position
-				model = glm::translate(model, transform.position.ToGlm());
-				//X, Y, Z euler rotations
-				model = glm::rotate(model, glm::radians(transform.rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-				model = glm::rotate(model, glm::radians(transform.rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-				model = glm::rotate(model, glm::radians(transform.rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
-				//Scale
-				model = glm::scale(model, transform.scale.ToGlm());
-
-				//Give the shader the model matrix
-				unsigned int modelLoc = glGetUniformLocation(shader->ID, "model");
-				glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-
-				//Give the shader the view matrix
-				unsigned int viewLoc = glGetUniformLocation(shader->ID, "view");
-				glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(cam->GetViewMatrix()));
-
-				//Give the shader the projection matrix
-				unsigned int projLoc = glGetUniformLocation(shader->ID, "projection");
-				glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(cam->GetProjectionMatrix()));
-
-                 // lighting color
-				unsigned int colorLoc = glGetUniformLocation(shader->ID, "lightColor");
-				glUniform3f(colorLoc, lightColor.x/255, lightColor.y/255 , lightColor.z/255);
-
-				// lighting position
-				unsigned int lightPosLoc = glGetUniformLocation(shader->ID, "lightPos");
-				glUniform3f(lightPosLoc, lightPos.x, lightPos.y, lightPos.z);
-
-				// camara pposition
-				unsigned int viewPosLoc = glGetUniformLocation(shader->ID, "viewPos");
-				glUniform3fv(viewPosLoc,1, glm::value_ptr(cam->position));
-
-
-				//For each mesh in the model
-				for (unsigned int i = 0; i < modelRenderer.model->meshes.size(); i++)
+			//Only draw the models the camera can see
+			visible.clear();
+			if (frustumCulling)
+			{
+				for (const Entity& entity : entities)
 				{
-					Mesh mesh = modelRenderer.model->meshes[i];
-
-					//Texture uniforms are named: uniform sampler2D texture_diffuseN, or texture_specularN
-					//We can support up to 8 textures which have to be defined in the shader
-					unsigned int diffuseNr = 1;
-					unsigned int specularNr = 1;
+					Transform& transform = ecs.getComponent<Transform>(entity);
+					ModelRenderer& modelRenderer = ecs.getComponent<ModelRenderer>(entity);
 
-					//For each Texture in the mesh
-					for (unsigned int i = 0; i < mesh.textures.size(); i++)
+					//A model that failed to load has nothing to draw, and transforming its empty bounds gives nonsense
+					if (modelRenderer.model->bounds.Empty())
 					{
-						//Activate proper texture unit before binding
-						glActiveTexture(GL_TEXTURE0 + i);
+						grid.Remove(entity);
+						continue;
+					}
+
+					//Only compute new bounds if the transform has changed
+					const glm::mat4& model = TransformSystem::GetModelMatrix(transform);
+					if (!grid.UpToDate(entity, transform.version))
+						grid.Update(entity, modelRenderer.model->bounds.Transformed(model), transform.version);
+				}
+				grid.QueryVisible(cam->GetFrustum(), entities, visible);
+			}
+			else
+			{
+				visible.assign(entities.begin(), entities.end());
+			}
 
-						//Retrieve texture number and type (the N in texture_{type}N)
-						std::string number;
-						std::string name = mesh.textures[i]->type;
-						if (name == "texture_diffuse")
-							number = std::to_string(diffuseNr++);
-						else if (name == "texture_specular")
-							number = std::to_string(specularNr++);
+			//Models with the default shader are grouped by model and drawn instanced, others are drawn one by one
+			instancedEntities.clear();
+			for (const Entity& entity : visible)
+			{
+				ModelRenderer& modelRenderer = ecs.getComponent<ModelRenderer>(entity);
+				if (modelRenderer.shader)
+					DrawSingle(entity, modelRenderer, cam);
+				else
+					instancedEntities.push_back({ modelRenderer.model, entity });
+			}
+			if (instancedEntities.empty())
+				return;
 
-						//Set the uniform for the material texture
-						glUniform1i(glGetUniformLocation(shader->ID, (/*"material." + */name + number).c_str()), i);
+			//Sorting puts every entity with the same model next to each other
+			std::sort(instancedEntities.begin(), instancedEntities.end());
 
-						glBindTexture(GL_TEXTURE_2D, mesh.textures[i]->ID());
-					}
+			//Collect the instance data of every group into one buffer
+			instances.clear();
+			for (const auto& [model, entity] : instancedEntities)
+			{
+				Transform& transform = ecs.getComponent<Transform>(entity);
+				const glm::mat4& modelMatrix = TransformSystem::GetModelMatrix(transform);
+				instances.push_back(ModelInstance{ modelMatrix, glm::inverseTranspose(glm::mat3(modelMatrix)) });
+			}
 
-					//Unbind texture
-					glActiveTexture(GL_TEXTURE0);
+			if (!instanceVBO)
+				glGenBuffers(1, &instanceVBO);
+			RenderState::Get()->BindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+			glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(ModelInstance), nullptr, GL_STREAM_DRAW);
+			glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(ModelInstance), instances.data());
 
-					//Draw mesh
-					glBindVertexArray(mesh.VAO);
-					glDrawElements(GL_TRIANGLES, mesh.indices.size(), GL_UNSIGNED_INT, 0);
-					glBindVertexArray(0);
+			//Everything in the instanced groups shares the shader, camera, and lighting
+			defaultShader->use();
+			cameraBuffer->Use(defaultShader);
+			SetLighting(defaultShader, cam);
+
+			//Draw each mesh of each group with one draw call
+			size_t first = 0;
+			while (first < instancedEntities.size())
+			{
+				Model* model = instancedEntities[first].first;
+				size_t count = 1;
+				while (first + count < instancedEntities.size() && instancedEntities[first + count].first == model)
+					count++;
+
+				for (Mesh& mesh : model->meshes)
+				{
+					BindTextures(defaultShader, mesh);
+					RenderState::Get()->BindVertexArray(mesh.VAO);
+					PointInstanceAttributes(mesh, first);
+					glDrawElementsInstanced(GL_TRIANGLES, mesh.indexCount, mesh.indexType, 0, count);
 				}
+				first += count;
 			}
 		}
 
 		Vector3 lightPos;
 		Vector3 lightColor = Vector3(255);
 
+		//Skip models outside the camera's view
+		bool frustumCulling = true;
+
+		//The grid used for culling, for drawing its cells with DebugDraw
+		const SpatialGrid& Grid() const
+		{
+			return grid;
+		}
 
 		Shader* defaultShader;
+
+	private:
+		//Per instance data for the default shader
+		struct ModelInstance
+		{
+			glm::mat4 model;
+			glm::mat3 normal;
+		};
+
+		//Draw one entity with its own shader, which gets the model matrix as a uniform
+		void DrawSingle(Entity entity, ModelRenderer& modelRenderer, Camera* cam)
+		{
+			Shader* shader = modelRenderer.shader;
+			shader->use();
+
+			//The model matrix is the same for each mesh, and is only rebuilt if the transform changed
+			Transform& transform = ecs.getComponent<Transform>(entity);
+			shader->SetMat4("model", TransformSystem::GetModelMatrix(transform));
+
+			//Give the shader the view and projection matrices
+			CameraUniformBuffer::Get()->Use(shader);
+			SetLighting(shader, cam);
+
+			//For each mesh in the model
+			for (const Mesh& mesh : modelRenderer.model->meshes)
+			{
+				BindTextures(shader, mesh);
+
+				//Draw mesh
+				RenderState::Get()->BindVertexArray(mesh.VAO);
+				glDrawElements(GL_TRIANGLES, mesh.indexCount, mesh.indexType, 0);
+			}
+		}
+
+		void SetLighting(Shader* shader, Camera* cam)
+		{
+			// lighting color
+			shader->SetVec3("lightColor", lightColor.ToGlm() / 255.0f);
+
+			// lighting position
+			shader->SetVec3("lightPos", lightPos.ToGlm());
+
+			// camara pposition
+			shader->SetVec3("viewPos", cam->position);
+		}
+
+		void BindTextures(Shader* shader, const Mesh& mesh)
+		{
+			//Texture uniforms are named: uniform sampler2D texture_diffuseN, or texture_specularN
+			//We can support up to 8 textures which have to be defined in the shader
+			unsigned int diffuseNr = 1;
+			unsigned int specularNr = 1;
+
+			//For each Texture in the mesh
+			for (unsigned int i = 0; i < mesh.textures.size(); i++)
+			{
+				//Retrieve texture number and type (the N in texture_{type}N)
+				std::string number;
+				const std::string& name = mesh.textureTypes[i];
+				if (name == "texture_diffuse")
+					number = std::to_string(diffuseNr++);
+				else if (name == "texture_specular")
+					number = std::to_string(specularNr++);
+
+				//Set the uniform for the material texture
+				shader->SetInt(/*"material." + */name + number, i);
+
+				//Bind the texture to its own unit
+				mesh.textures[i]->Use(i);
+			}
+		}
+
+		//Point the instance attributes of mesh's vertex array at the instance buffer, starting from firstInstance
+		//OpenGL 3.3 has no base instance, so this has to be done for every draw. The vertex array must be bound
+		void PointInstanceAttributes(Mesh& mesh, size_t firstInstance)
+		{
+			RenderState::Get()->BindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+			size_t offset = firstInstance * sizeof(ModelInstance);
+
+			//A matrix attribute takes one location per column
+			for (unsigned int i = 0; i < 4; i++)
+				glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE, sizeof(ModelInstance), (void*)(offset + offsetof(ModelInstance, model) + i * sizeof(glm::vec4)));
+			for (unsigned int i = 0; i < 3; i++)
+				glVertexAttribPointer(7 + i, 3, GL_FLOAT, GL_FALSE, sizeof(ModelInstance), (void*)(offset + offsetof(ModelInstance, normal) + i * sizeof(glm::vec3)));
+
+			//Enabling the attributes only has to be done once per vertex array
+			if (!mesh.instanceAttributes)
+			{
+				for (unsigned int i = 3; i < 10; i++)
+				{
+					glVertexAttribDivisor(i, 1);
+					glEnableVertexAttribArray(i);
+				}
+				mesh.instanceAttributes = true;
+			}
+		}
+
+		SpatialGrid grid;
+		std::vector<Entity> visible;
+
+		std::vector<std::pair<Model*, Entity>> instancedEntities;
+		std::vector<ModelInstance> instances;
+		unsigned int instanceVBO = 0;
 	};
 }
\ No newline at end of file
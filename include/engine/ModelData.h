@@ -0,0 +1,33 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <engine/GL/Mesh.h>
+#include <engine/GL/Frustum.h>
+
+namespace engine
+{
+	//A texture used by a mesh's material, path is relative to the model file
+	struct MaterialTexture
+	{
+		std::string type;
+		std::string path;
+	};
+
+	//CPU side data of one mesh, before it is uploaded
+	struct MeshData
+	{
+		std::vector<Mesh::Vertex> vertices;
+		std::vector<unsigned int> indices;
+		std::vector<MaterialTexture> textures;
+		AABB bounds;
+		//How the vertices should be stored on the GPU
+		Mesh::VertexFormat vertexFormat = Mesh::VertexFormat::standard;
+	};
+
+	//CPU side data of a whole model, as imported by Model::Import
+	struct ModelData
+	{
+		std::vector<MeshData> meshes;
+		AABB bounds;
+	};
+}
@@ -4,6 +4,7 @@
 #include <engine/Tilemap.h>
 #include <vector>
 #include <array>
+#include <algorithm>
 
 namespace engine
 {
@@ -40,6 +41,20 @@ namespace engine
 		float friction = 0;
 		float elasticity = 0;
 		bool kinematic = false;
+
+		//Level-of-detail state, this is managed by the Physics System
+		int lodInterval = 1;
+		int lodHold = 0;
+		float lodTimer = 0;
+		float lodDeltaTime = 0;
+	};
+
+	//Physics level-of-detail tier. Not a component
+	//Bodies at least distance away from every observer are only simulated every interval frames, with a proportionally larger delta time
+	struct PhysicsLODTier
+	{
+		float distance;
+		int interval;
 	};
 
 	//Box collider component
@@ -69,6 +84,9 @@ namespace engine
 		{
 			deltaTime = min(deltaTime, 0.1f);
 
+			//Decide which bodies get simulated this frame and with how large of a delta time
+			UpdateLOD(deltaTime);
+
 			//For each physics step per frame
 			for (int i = 0; i < step; i++)
 			{
@@ -86,22 +104,118 @@ namespace engine
 						collider.collisions.clear();
 					}
 
+					//Bodies on a reduced tier skip the frames between their ticks
+					if (rigidbody.lodDeltaTime == 0)
+						continue;
+
 					//Don't affect static rigidbodies
 					if (!rigidbody.kinematic)
 					{
 						//Apply gravity
-						rigidbody.velocity += gravity * rigidbody.gravityScale / step * deltaTime;
+						rigidbody.velocity += gravity * rigidbody.gravityScale / step * rigidbody.lodDeltaTime;
 
 						//Apply drag
-						rigidbody.velocity -= rigidbody.velocity * rigidbody.drag / step * deltaTime;
+						rigidbody.velocity -= rigidbody.velocity * rigidbody.drag / step * rigidbody.lodDeltaTime;
+					}
+
+					//Move the entity, bodies on a reduced tier in one substep per frame they skipped
+					//so they check collision as often as full rate bodies and don't tunnel through thin colliders
+					int substeps = max(1, (int)ceil(rigidbody.lodDeltaTime / deltaTime - 0.001f));
+					Move(entity, rigidbody.velocity / step * rigidbody.lodDeltaTime / substeps, substeps);
+				}
+			}
+
+			if (visualize)
+				Visualize();
+		}
+
+		//Draw every box collider with DebugDraw, triggers in yellow, sides which collided this frame in red
+		//Contacts between entities are marked with a cross in the middle of where the boxes meet
+		//Defined in Physics.cpp so DebugDraw and its text rendering aren't included everywhere physics is
+		void Visualize();
+
+		//Pick a level-of-detail tier for every body based on its distance to the nearest observer
+		//Sets each body's lodDeltaTime to the time it should be simulated for this frame, or 0 if it should be skipped
+		void UpdateLOD(float deltaTime)
+		{
+			lodFrame++;
+
+			//Gather the observer positions once per frame
+			vector<Vector2> observers;
+			for (const Entity& observer : lodObservers)
+			{
+				if (ecs.entityExists(observer) && ecs.hasComponent<Transform>(observer))
+					observers.push_back(ecs.getComponent<Transform>(observer).position);
+			}
+			//The camera's world position is double its stored position, see Camera::SetPosition
+			if (lodCamera)
+				observers.push_back(Vector2(lodCamera->position.x * 2, lodCamera->position.y * 2));
+
+			for (auto const& entity : entities)
+			{
+				Rigidbody& rigidbody = ecs.getComponent<Rigidbody>(entity);
+
+				//Without tiers or observers everything runs at full rate
+				int interval = 1;
+				if (!lodTiers.empty() && !observers.empty() && rigidbody.lodHold <= 0)
+				{
+					//Squared distance to the nearest observer
+					Vector2 position = ecs.getComponent<Transform>(entity).position;
+					float nearest = INFINITY;
+					for (Vector2& observer : observers)
+						nearest = min(nearest, (observer - position).Squared());
+
+					//The furthest tier the body is past wins, whatever order the tiers are in
+					float tierDistance = -1;
+					for (const PhysicsLODTier& tier : lodTiers)
+					{
+						if (nearest >= tier.distance * tier.distance && tier.distance > tierDistance)
+						{
+							tierDistance = tier.distance;
+							interval = max(tier.interval, 1);
+						}
 					}
+				}
+
+				if (rigidbody.lodHold > 0)
+					rigidbody.lodHold--;
 
-					//Move the entity
-					Move(entity, rigidbody.velocity / step * deltaTime, 1);
+				rigidbody.lodInterval = interval;
+				rigidbody.lodTimer += deltaTime;
+
+				//Stagger the reduced bodies over frames by their id so they don't all tick on the same frame
+				if (interval == 1 || (lodFrame + entity) % interval == 0)
+				{
+					//Never simulate more than one full tier interval worth of time at once
+					rigidbody.lodDeltaTime = min(rigidbody.lodTimer, 0.1f * interval);
+					rigidbody.lodTimer = 0;
+				}
+				else
+				{
+					rigidbody.lodDeltaTime = 0;
 				}
 			}
 		}
 
+		//Force entity to be simulated at full rate for lodContactHold frames
+		//This is done automatically when a body on a reduced tier touches a body on a higher one
+		void WakeLOD(Entity entity)
+		{
+			Rigidbody& rigidbody = ecs.getComponent<Rigidbody>(entity);
+			rigidbody.lodHold = lodContactHold;
+			rigidbody.lodInterval = 1;
+		}
+
+		//Set the level-of-detail tiers, sorted by distance for readability, lodTiers can be set in any order too
+		void SetLODTiers(vector<PhysicsLODTier> tiers)
+		{
+			sort(tiers.begin(), tiers.end(), [](const PhysicsLODTier& lhs, const PhysicsLODTier& rhs)
+				{
+					return lhs.distance < rhs.distance;
+				});
+			lodTiers = tiers;
+		}
+
 		//Move an entity while checking collision at every step
 		//If a collision occurs returns the step it occured on, entity is also moved up to the collision
 		int Move(Entity entity, Vector2 direction, int stepOverride = 0)
@@ -217,6 +331,15 @@ namespace engine
 				Collision collision = AABBIntersect(a, b);
 				if (collision.type != Collision::Type::miss)
 				{
+					//When bodies on different level-of-detail tiers touch, bring the slower one up to full rate
+					//so it doesn't respond to the contact several frames late with a large step
+					Rigidbody& aRigidbody = ecs.getComponent<Rigidbody>(a);
+					Rigidbody& bRigidbody = ecs.getComponent<Rigidbody>(b);
+					if (aRigidbody.lodInterval != bRigidbody.lodInterval)
+					{
+						WakeLOD(aRigidbody.lodInterval > bRigidbody.lodInterval ? a : b);
+					}
+
 					if (collision.type == Collision::Type::entityTrigger)
 					{
 						//In the case of a trigger make sure the same entity collision is not logged multiple times
@@ -447,10 +570,22 @@ namespace engine
 		}
 
 		int step = 4;
+		//Draw the colliders and contacts with DebugDraw every update
+		bool visualize = false;
 		//Pixels/second^2
 		Vector2 gravity;
 
+		//Level-of-detail tiers in any order. If empty every body is simulated every frame
+		vector<PhysicsLODTier> lodTiers;
+		//Entities which bodies are measured against when choosing a tier, usually the players
+		vector<Entity> lodObservers;
+		//Optional camera which is also used as an observer
+		Camera* lodCamera = nullptr;
+		//How many frames a body stays at full rate after it touched a body on a higher tier
+		int lodContactHold = 30;
+
 	private:
+		unsigned int lodFrame = 0;
 		Tilemap* tilemap = nullptr;
 		map<unsigned int, Rigidbody> tileProperties;
 	};
@@ -16,6 +16,8 @@
 #include <engine/GL/Shader.h>
 #include <engine/GL/Texture.h>
 #include <engine/GL/Camera.h>
+#include <engine/GL/UniformBuffer.h>
+#include <engine/SpatialGrid.h>
 
 extern ECS ecs;
 
@@ -29,20 +31,23 @@ namespace engine
 		{
 			numVertices = indices.size();
 
+			//Local bounds for culling
+			for (size_t i = 0; i + 2 < vertices.size(); i += 3)
+				bounds.Expand(glm::vec3(vertices[i], vertices[i + 1], vertices[i + 2]));
 			//Make the Vertex Array Object, Vertex Buffer Object, and Element Buffer Object
 			glGenVertexArrays(1, &VAO);
 			glGenBuffers(1, &VBO);
 			glGenBuffers(1, &EBO);
 
 			//Bind the Vertex Array Object
-			glBindVertexArray(VAO);
+			RenderState::Get()->BindVertexArray(VAO);
 
 			//Bind the Vertex Bufer Object and set vertices
-			glBindBuffer(GL_ARRAY_BUFFER, VBO);
+			RenderState::Get()->BindBuffer(GL_ARRAY_BUFFER, VBO);
 			glBufferData(GL_ARRAY_BUFFER, sizeof(float) * vertices.size(), vertices.data(), GL_STATIC_DRAW);
 
 			//Bind and set indices to EBO
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+			RenderState::Get()->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
 			glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * indices.size(), indices.data(), GL_STATIC_DRAW);
 
 			//Configure Vertex attribute at location 0 aka position
@@ -50,14 +55,17 @@ namespace engine
 			glEnableVertexAttribArray(0);
 
 			//Unbind all buffers and arrays
-			glBindVertexArray(0);
-			glBindBuffer(GL_ARRAY_BUFFER, 0);
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+			RenderState::Get()->BindVertexArray(0);
+			RenderState::Get()->BindBuffer(GL_ARRAY_BUFFER, 0);
+			RenderState::Get()->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 		}
 
 	public:
 		~Primitive()
 		{
+			RenderState::Get()->DeleteVertexArray(VAO);
+			RenderState::Get()->DeleteBuffer(VBO);
+			RenderState::Get()->DeleteBuffer(EBO);
 			glDeleteVertexArrays(1, &VAO);
 			glDeleteBuffers(1, &VBO);
 			glDeleteBuffers(1, &EBO);
@@ -168,6 +176,7 @@ namespace engine
 
 		unsigned int numVertices = 0;
 		unsigned int VAO, VBO, EBO;
+		AABB bounds;
 	};
 
 	//Primitive Renderer Component
@@ -195,8 +204,11 @@ namespace engine
 				layout(location = 0) in vec3 aPos;
 
 				uniform mat4 model;
-				uniform mat4 view;
-				uniform mat4 projection;
+				layout(std140) uniform Camera
+				{
+					mat4 view;
+					mat4 projection;
+				};
 				uniform vec4 color;
 
 				out vec4 vertexColor;			
@@ -222,8 +234,46 @@ namespace engine
 
 		void Update(Camera* cam)
 		{
-			//For each entity
-			for (const Entity& entity : entities)
+			//Upload the camera matrices for every shader at once
+			CameraUniformBuffer* cameraBuffer = CameraUniformBuffer::Get();
+			cameraBuffer->Update(cam);
+
+			//Only draw the primitives the camera can see, UI elements are always drawn
+			visible.clear();
+			if (frustumCulling)
+			{
+				for (const Entity& entity : entities)
+				{
+					Transform& transform = ecs.getComponent<Transform>(entity);
+					PrimitiveRenderer& primitiveRenderer = ecs.getComponent<PrimitiveRenderer>(entity);
+					if (primitiveRenderer.uiElement)
+					{
+						grid.Remove(entity);
+						visible.push_back(entity);
+						continue;
+					}
+
+					//Without vertices there is nothing to cull or draw
+					if (primitiveRenderer.primitive->bounds.Empty())
+					{
+						grid.Remove(entity);
+						continue;
+					}
+
+					//Only compute new bounds if the transform has changed
+					const glm::mat4& model = TransformSystem::GetModelMatrix(transform);
+					if (!grid.UpToDate(entity, transform.version))
+						grid.Update(entity, primitiveRenderer.primitive->bounds.Transformed(model), transform.version);
+				}
+				grid.QueryVisible(cam->GetFrustum(), entities, visible);
+			}
+			else
+			{
+				visible.assign(entities.begin(), entities.end());
+			}
+
+			//For each visible entity
+			for (const Entity& entity : visible)
 			{
 				//Get relevant components
 				Transform& transform = ecs.getComponent<Transform>(entity);
@@ -235,47 +285,19 @@ namespace engine
 				defaultShader->use();
 
 				//Bind the right VAO after tilemap
-				glBindVertexArray(primitiveRenderer.primitive->VAO);
-
-				//Create the model matrix
-				glm::mat4 model = glm::mat4(1.0f);
-				//Position
-				model = glm::translate(model, transform.position.ToGlm());
-				//X, Y, Z euler rotations
-				model = glm::rotate(model, glm::radians(transform.rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-				model = glm::rotate(model, glm::radians(transform.rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-				model = glm::rotate(model, glm::radians(transform.rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
-				//Scale
-				model = glm::scale(model, transform.scale.ToGlm());
+				RenderState::Get()->BindVertexArray(primitiveRenderer.primitive->VAO);
+
+				//The model matrix is only rebuilt if the transform changed
+				const glm::mat4& model = TransformSystem::GetModelMatrix(transform);
 
 				//Give the shader the model matrix
-				unsigned int modelLoc = glGetUniformLocation(defaultShader->ID, "model");
-				glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+				defaultShader->SetMat4("model", model);
 
 				//Give the shader the primitive's color
-				unsigned int colorLoc = glGetUniformLocation(defaultShader->ID, "color");
-				glUniform4f(colorLoc, primitiveRenderer.color.x / 255, primitiveRenderer.color.y / 255, primitiveRenderer.color.z / 255, 1);
-
-				//Get the view and projection locations
-				unsigned int viewLoc = glGetUniformLocation(defaultShader->ID, "view");
-				unsigned int projLoc = glGetUniformLocation(defaultShader->ID, "projection");
+				defaultShader->SetVec4("color", glm::vec4(primitiveRenderer.color.ToGlm() / 255.0f, 1));
 
-				if (!primitiveRenderer.uiElement)
-				{
-					//Give the shader the camera's view matrix
-					glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(cam->GetViewMatrix()));
-
-					//Give the shader the camera's projection matrix
-					glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(cam->GetProjectionMatrix()));
-				}
-				else
-				{
-					//Give the shader a constant view matrix
-					glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(glm::mat4(1.0f)));
-
-					//Give the shader a constant projection matrix
-					glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(glm::mat4(1.0f)));
-				}
+				//UI elements are drawn with constant view and projection matrices
+				cameraBuffer->Use(defaultShader, primitiveRenderer.uiElement ? CameraUniformBuffer::Slot::screen : CameraUniformBuffer::Slot::world);
 
 				//Render either as lines or triangles
 				if (primitiveRenderer.wireframe || primitiveRenderer.primitive->numVertices < 3)
@@ -285,11 +307,21 @@ namespace engine
 
 				int a = 0;
 			}
+		}
+
+		//Skip primitives outside the camera's view
+		bool frustumCulling = true;
 
-			//Unbind vertex array
-			glBindVertexArray(0);
+		//The grid used for culling, for drawing its cells with DebugDraw
+		const SpatialGrid& Grid() const
+		{
+			return grid;
 		}
 
 		Shader* defaultShader;
+
+	private:
+		SpatialGrid grid;
+		std::vector<Entity> visible;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,267 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <set>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <engine/ECSCore.h>
+#include <engine/GL/Frustum.h>
+
+namespace engine
+{
+	//A uniform grid over the XY plane storing entities by their bounds, for finding everything in an area without checking every entity
+	//Entities are only moved between cells when the range of cells they touch changes, so updating something which hasn't moved is cheap
+	class SpatialGrid
+	{
+	public:
+		//Entities touching more cells than this are kept in a separate list which every query returns
+		static const int MAX_CELLS_PER_ENTITY = 64;
+
+		SpatialGrid(float cellSize = 256) : cellSize(cellSize)
+		{
+			entries.resize(MAX_ENTITIES);
+		}
+
+		//Insert entity or move it to its new bounds
+		//version identifies what the bounds were computed from, for example the transform's version, see UpToDate()
+		void Update(Entity entity, const AABB& bounds, unsigned int version = 0)
+		{
+			//Empty bounds have no cells, casting their infinite coordinates to cells would be undefined
+			if (bounds.Empty())
+			{
+				Remove(entity);
+				return;
+			}
+
+			Entry& entry = entries[entity];
+			CellRange range = GetRange(bounds);
+			entry.version = version;
+
+			if (entry.inserted && entry.range == range)
+			{
+				entry.bounds = bounds;
+				return;
+			}
+
+			if (entry.inserted)
+				Unlink(entity, entry);
+
+			entry.bounds = bounds;
+			entry.range = range;
+			entry.inserted = true;
+			Link(entity, entry);
+		}
+
+		//Take entity out of the grid
+		void Remove(Entity entity)
+		{
+			Entry& entry = entries[entity];
+			if (!entry.inserted)
+				return;
+
+			Unlink(entity, entry);
+			entry.inserted = false;
+		}
+
+		bool Contains(Entity entity) const
+		{
+			return entries[entity].inserted;
+		}
+
+		//Returns true if entity is in the grid with bounds computed from version, so they don't need to be computed again
+		bool UpToDate(Entity entity, unsigned int version) const
+		{
+			return entries[entity].inserted && entries[entity].version == version;
+		}
+
+		const AABB& GetBounds(Entity entity) const
+		{
+			return entries[entity].bounds;
+		}
+
+		float CellSize() const
+		{
+			return cellSize;
+		}
+
+		//Call function(x, y, count) for every cell with entities in it, x and y are in cells, multiply by CellSize() for world units
+		//Entities too large for the grid aren't in any cell, see OversizedCount()
+		template<typename Function>
+		void ForEachCell(Function function) const
+		{
+			for (const auto& cell : cells)
+			{
+				if (!cell.second.empty())
+					function((int)(int32_t)(cell.first >> 32), (int)(int32_t)(cell.first & 0xFFFFFFFF), cell.second.size());
+			}
+		}
+
+		size_t OversizedCount() const
+		{
+			return oversized.size();
+		}
+
+		//Add every entity whose bounds overlap area to result, each entity is only added once
+		void Query(const AABB& area, std::vector<Entity>& result)
+		{
+			//Stamp entities as they are found so ones spanning several cells aren't added twice
+			queryStamp++;
+
+			for (Entity entity : oversized)
+				Visit(entity, area, result);
+
+			CellRange range = GetRange(area);
+			int64_t cellCount = (int64_t)(range.maxX - range.minX + 1) * (range.maxY - range.minY + 1);
+
+			//A huge area, for example a far perspective frustum, has fewer occupied cells than cells in range
+			if (cellCount > (int64_t)cells.size())
+			{
+				for (auto& cell : cells)
+				{
+					int x = (int32_t)(cell.first >> 32);
+					int y = (int32_t)(cell.first & 0xFFFFFFFF);
+					if (x < range.minX || x > range.maxX || y < range.minY || y > range.maxY)
+						continue;
+
+					for (Entity entity : cell.second)
+						Visit(entity, area, result);
+				}
+				return;
+			}
+
+			for (int y = range.minY; y <= range.maxY; y++)
+			{
+				for (int x = range.minX; x <= range.maxX; x++)
+				{
+					auto cell = cells.find(CellKey(x, y));
+					if (cell == cells.end())
+						continue;
+
+					for (Entity entity : cell->second)
+						Visit(entity, area, result);
+				}
+			}
+		}
+
+		//Find the entities of a system which are inside frustum, sorted by id so the draw order doesn't change as they move between cells
+		//Entities which are no longer in the system are removed from the grid
+		void QueryVisible(const Frustum& frustum, const std::set<Entity>& members, std::vector<Entity>& result)
+		{
+			size_t first = result.size();
+			Query(frustum.bounds, result);
+
+			size_t kept = first;
+			for (size_t i = first; i < result.size(); i++)
+			{
+				Entity entity = result[i];
+				if (!members.count(entity))
+				{
+					Remove(entity);
+					continue;
+				}
+				if (frustum.Intersects(entries[entity].bounds))
+					result[kept++] = entity;
+			}
+			result.resize(kept);
+			std::sort(result.begin() + first, result.end());
+		}
+
+	private:
+		struct CellRange
+		{
+			int minX = 0, minY = 0, maxX = -1, maxY = -1;
+
+			bool operator==(const CellRange& rhs) const
+			{
+				return minX == rhs.minX && minY == rhs.minY && maxX == rhs.maxX && maxY == rhs.maxY;
+			}
+		};
+
+		struct Entry
+		{
+			AABB bounds;
+			CellRange range;
+			bool inserted = false;
+			bool oversized = false;
+			unsigned int version = 0;
+			unsigned int stamp = 0;
+		};
+
+		CellRange GetRange(const AABB& bounds) const
+		{
+			//Clamp so nonsense bounds can't overflow the cell coordinates
+			const float limit = 1e9f;
+			CellRange range;
+			range.minX = (int)std::floor(std::clamp(bounds.min.x / cellSize, -limit, limit));
+			range.minY = (int)std::floor(std::clamp(bounds.min.y / cellSize, -limit, limit));
+			range.maxX = (int)std::floor(std::clamp(bounds.max.x / cellSize, -limit, limit));
+			range.maxY = (int)std::floor(std::clamp(bounds.max.y / cellSize, -limit, limit));
+			return range;
+		}
+
+		static uint64_t CellKey(int x, int y)
+		{
+			return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y;
+		}
+
+		void Link(Entity entity, Entry& entry)
+		{
+			const CellRange& range = entry.range;
+			entry.oversized = (int64_t)(range.maxX - range.minX + 1) * (range.maxY - range.minY + 1) > MAX_CELLS_PER_ENTITY;
+			if (entry.oversized)
+			{
+				oversized.push_back(entity);
+				return;
+			}
+
+			for (int y = range.minY; y <= range.maxY; y++)
+				for (int x = range.minX; x <= range.maxX; x++)
+					cells[CellKey(x, y)].push_back(entity);
+		}
+
+		void Unlink(Entity entity, Entry& entry)
+		{
+			if (entry.oversized)
+			{
+				EraseFrom(oversized, entity);
+				return;
+			}
+
+			const CellRange& range = entry.range;
+			for (int y = range.minY; y <= range.maxY; y++)
+			{
+				for (int x = range.minX; x <= range.maxX; x++)
+				{
+					//Empty cells are kept, entities moving back and forth would otherwise reallocate them
+					EraseFrom(cells[CellKey(x, y)], entity);
+				}
+			}
+		}
+
+		//Order within a cell doesn't matter, so swap with the last element instead of shifting
+		static void EraseFrom(std::vector<Entity>& list, Entity entity)
+		{
+			auto it = std::find(list.begin(), list.end(), entity);
+			*it = list.back();
+			list.pop_back();
+		}
+
+		void Visit(Entity entity, const AABB& area, std::vector<Entity>& result)
+		{
+			Entry& entry = entries[entity];
+			if (entry.stamp == queryStamp)
+				return;
+			entry.stamp = queryStamp;
+
+			if (entry.bounds.Overlaps(area))
+				result.push_back(entity);
+		}
+
+		float cellSize;
+		std::vector<Entry> entries;
+		std::unordered_map<uint64_t, std::vector<Entity>> cells;
+		std::vector<Entity> oversized;
+		unsigned int queryStamp = 0;
+	};
+}
@@ -16,6 +16,10 @@
 #include <engine/GL/Shader.h>
 #include <engine/GL/Texture.h>
 #include <engine/GL/Camera.h>
+#include <engine/GL/SpriteBatch.h>
+#include <engine/GL/RenderQueue.h>
+#include <engine/SpatialGrid.h>
+#include <engine/GL/UniformBuffer.h>
 #include <engine/Tilemap.h>
 
 extern ECS ecs;
@@ -31,6 +35,8 @@ namespace engine
 		Shader* shader = nullptr;
 		bool enabled = true;
 		bool uiElement = false;
+		//The part of the texture to draw as min x, min y, max x, max y in texture coordinates
+		glm::vec4 uvRect = glm::vec4(0, 0, 1, 1);
 	};
 
 	//Animation struct. Not a component
@@ -44,7 +50,16 @@ namespace engine
 			delays = animationDelays;
 			length = animationDelays.size();
 		};
+		//Frames which are parts of textures, such as a texture atlas. Each frame is drawn from its uv rect of its texture
+		Animation(vector<Texture*> animationTextures, vector<glm::vec4> animationUVRects, vector<int> animationDelays)
+			: Animation(animationTextures, animationDelays)
+		{
+			assert(animationUVRects.size() == animationDelays.size() && "Failed to create animation! Number of frames and uv rects do not match!");
+			uvRects = animationUVRects;
+		};
 		vector<Texture*> textures;
+		//Empty if every frame is a whole texture
+		vector<glm::vec4> uvRects;
 		vector<int> delays;
 		unsigned int length = 0;
 	};
@@ -67,17 +82,22 @@ namespace engine
 	class SpriteRenderSystem : public System
 	{
 	public:
+		//How sprites using the default shader are drawn
+		//batched transforms every quad on the CPU, instanced uploads one model matrix and uv rect per sprite and transforms on the GPU
+		//Sprites with a custom shader are always batched
+		enum class RenderMode { batched, instanced };
+
 		SpriteRenderSystem()
 		{
 			//Set the screen clear color to black
 			glClearColor(0, 0, 0, 1.0f);
 
 			//Enable transparency
-			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-			glEnable(GL_BLEND);
+			RenderState::Get()->BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+			RenderState::Get()->Enable(GL_BLEND);
 			//Enable Depth buffering
-			glEnable(GL_DEPTH_TEST);
-			glDepthFunc(GL_LESS);
+			RenderState::Get()->Enable(GL_DEPTH_TEST);
+			RenderState::Get()->DepthFunc(GL_LESS);
 
 			//Create the default sprite shader
 			defaultShader = new Shader(
@@ -87,8 +107,11 @@ namespace engine
 				layout(location = 1) in vec2 aTexCoord;
 				out vec2 TexCoord;
 				uniform mat4 model;
-				uniform mat4 view;
-				uniform mat4 projection;
+				layout(std140) uniform Camera
+				{
+					mat4 view;
+					mat4 projection;
+				};
 				void main()
 				{
 					gl_Position = projection * view * model * vec4(aPos, 1.0f);
@@ -106,6 +129,41 @@ namespace engine
 				}
 				)", false);
 
+			//Create the instanced version of the default shader
+			//The model matrix rows and uv rect come from the per-instance attributes set up by SpriteBatch
+			instancedShader = new Shader(
+				R"(
+				#version 330 core
+				layout (location = 0) in vec3 aPos;
+				layout(location = 1) in vec2 aTexCoord;
+				layout(location = 2) in vec4 aModelRow0;
+				layout(location = 3) in vec4 aModelRow1;
+				layout(location = 4) in vec4 aModelRow2;
+				layout(location = 5) in vec4 aUVRect;
+				out vec2 TexCoord;
+				layout(std140) uniform Camera
+				{
+					mat4 view;
+					mat4 projection;
+				};
+				void main()
+				{
+					mat4 model = transpose(mat4(aModelRow0, aModelRow1, aModelRow2, vec4(0.0f, 0.0f, 0.0f, 1.0f)));
+					gl_Position = projection * view * model * vec4(aPos, 1.0f);
+					TexCoord = mix(aUVRect.xy, aUVRect.zw, aTexCoord);
+				}
+				)",
+				R"(
+				#version 330 core
+				out vec4 FragColor;
+				in vec2 TexCoord;
+				uniform sampler2D texture1;
+				void main()
+				{
+				   FragColor = texture(texture1, TexCoord);
+				}
+				)", false);
+
 			//Rectangle vertices start at top left and go clockwise to bottom left
 			float vertices[] = {
 				//Positions		  Texture Coords
@@ -126,14 +184,14 @@ namespace engine
 			glGenBuffers(1, &EBO);
 
 			//Bind the Vertex Array Object
-			glBindVertexArray(VAO);
+			RenderState::Get()->BindVertexArray(VAO);
 
 			//Bind the Vertex Bufer Object and set vertices
-			glBindBuffer(GL_ARRAY_BUFFER, VBO);
+			RenderState::Get()->BindBuffer(GL_ARRAY_BUFFER, VBO);
 			glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
 			//Bind and set indices to EBO
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+			RenderState::Get()->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
 			glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
 
 			//Configure Vertex attribute at location 0 aka position
@@ -145,16 +203,19 @@ namespace engine
 			glEnableVertexAttribArray(1);
 
 			//Unbind all buffers and arrays
-			glBindVertexArray(0);
-			glBindBuffer(GL_ARRAY_BUFFER, 0);
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+			RenderState::Get()->BindVertexArray(0);
+			RenderState::Get()->BindBuffer(GL_ARRAY_BUFFER, 0);
+			RenderState::Get()->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 		}
 
 		~SpriteRenderSystem()
 		{
+			RenderState::Get()->DeleteVertexArray(VAO);
+			RenderState::Get()->DeleteBuffer(VBO);
+			RenderState::Get()->DeleteBuffer(EBO);
 			glDeleteVertexArrays(1, &VAO);
-			glDeleteVertexArrays(1, &VBO);
-			glDeleteVertexArrays(1, &EBO);
+			glDeleteBuffers(1, &VBO);
+			glDeleteBuffers(1, &EBO);
 		}
 
 		//Renders everything. Call this every frame
@@ -163,94 +224,94 @@ namespace engine
 			//Clear the screen
 			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-			//Sort the entities and tilemap by Z
-			set<float> layersToDraw;
+			//Upload the camera matrices for every shader at once
+			CameraUniformBuffer* cameraBuffer = CameraUniformBuffer::Get();
+			cameraBuffer->Update(cam);
+
+			//Queue every tilemap layer and enabled sprite with a key sorting them by Z, then shader and texture
+			queue.Clear();
+			tilemapLayers.clear();
 			if (tilemap)
-				layersToDraw.insert(tilemap->zLayers.begin(), tilemap->zLayers.end());
-			map<float, vector<Entity>> sortedEntities;
-			for (const Entity& entity : entities)
 			{
+				for (const float& layer : tilemap->zLayers)
+				{
+					queue.Push(RenderQueue::MakeKey(layer, RenderQueue::ItemType::tilemap, false, 0, 0), tilemapLayers.size());
+					tilemapLayers.push_back(layer);
+				}
+			}
+			for (const Entity& entity : VisibleSprites(cam))
+			{
+				SpriteRenderer& sprite = ecs.getComponent<SpriteRenderer>(entity);
+				if (!sprite.enabled)
+					continue;
+
+				//Sort by the world space Z, which differs from the position for entities with a parent
 				Transform& transform = ecs.getComponent<Transform>(entity);
-				sortedEntities[transform.position.z].push_back(entity);
-				layersToDraw.insert(transform.position.z);
+				float z = TransformSystem::GetModelMatrix(transform)[3].z;
+				unsigned int texture = sprite.texture ? sprite.texture->ID() : 0;
+				queue.Push(RenderQueue::MakeKey(z, RenderQueue::ItemType::sprite, sprite.uiElement, SpriteShader(sprite)->ID, texture), entity);
 			}
+			queue.Sort();
 
-			//Draw everything by layer
-			for (const float& layer : layersToDraw)
+			//Collect every sprite into batches of consecutive sprites sharing a texture and shader
+			//Tilemap layers split the batches and are drawn in between them
+			batch.Clear();
+			tilemapDraws.clear();
+			for (const RenderQueue::Item& item : queue.items)
 			{
-				if (tilemap)
-					tilemap->draw(layer);
+				if (RenderQueue::GetType(item.key) == RenderQueue::ItemType::tilemap)
+				{
+					tilemapDraws.push_back({ (unsigned int)batch.batches.size(), tilemapLayers[item.index] });
+					batch.Split();
+					continue;
+				}
 
-				//Bind the right VAO after tilemap
-				glBindVertexArray(VAO);
+				//Get relevant components
+				Entity entity = item.index;
+				SpriteRenderer& sprite = ecs.getComponent<SpriteRenderer>(entity);
+				Transform& transform = ecs.getComponent<Transform>(entity);
 
-				//Draw entities for this layer
-				for (const Entity& entity : sortedEntities[layer])
-				{
-					//Get relevant components
-					SpriteRenderer& sprite = ecs.getComponent<SpriteRenderer>(entity);
-					Transform& transform = ecs.getComponent<Transform>(entity);
-
-					if (!sprite.enabled)
-						continue;
-
-					//If a shader has been specified for this sprite use it, else use the default
-					Shader* shader = defaultShader;
-					if (sprite.shader)
-						shader = sprite.shader;
-					shader->use();
-
-					//Create the model matrix
-					glm::mat4 model = glm::mat4(1.0f);
-					//Position
-					model = glm::translate(model, transform.position.ToGlm());
-					//X, Y, Z euler rotations
-					model = glm::rotate(model, glm::radians(transform.rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-					model = glm::rotate(model, glm::radians(transform.rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-					model = glm::rotate(model, glm::radians(transform.rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
-					//Scale
-					model = glm::scale(model, transform.scale.ToGlm());
-
-					//Give the shader the model matrix
-					unsigned int modelLoc = glGetUniformLocation(shader->ID, "model");
-					glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-
-					//Get the view and projection locations
-					unsigned int viewLoc = glGetUniformLocation(shader->ID, "view");
-					unsigned int projLoc = glGetUniformLocation(shader->ID, "projection");
-
-					if (!sprite.uiElement)
-					{
-						//Give the shader the camera's view matrix
-						glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(cam->GetViewMatrix()));
+				//The model matrix is only rebuilt if the transform changed
+				const glm::mat4& model = TransformSystem::GetModelMatrix(transform);
 
-						//Give the shader the camera's projection matrix
-						glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(cam->GetProjectionMatrix()));
-					}
-					else
-					{
-						//Give the shader a constant view matrix
-						glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(glm::mat4(1.0f)));
+				unsigned int texture = sprite.texture ? sprite.texture->ID() : 0;
+				Shader* shader = SpriteShader(sprite);
 
-						//Give the shader a constant projection matrix
-						glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(glm::mat4(1.0f)));
-					}
+				if (shader == instancedShader)
+					batch.AddInstance(model, texture, shader, sprite.uiElement, sprite.uvRect);
+				else
+					batch.Add(model, texture, shader, sprite.uiElement, sprite.uvRect);
+			}
 
-					//Bind the texture
-					glActiveTexture(GL_TEXTURE0);
-					if (sprite.texture)
-						sprite.texture->Use();
+			//Stream every quad and instance to the GPU at once
+			batch.Upload(VAO);
 
-					//Draw the sprite
-					glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+			//Draw each batch, with the tilemap layers in their sorted places
+			unsigned int nextTilemapDraw = 0;
+			for (unsigned int i = 0; i < batch.batches.size(); i++)
+			{
+				for (; nextTilemapDraw < tilemapDraws.size() && tilemapDraws[nextTilemapDraw].first == i; nextTilemapDraw++)
+					tilemap->draw(tilemapDraws[nextTilemapDraw].second);
 
-					//Unbind the texture
-					glBindTexture(GL_TEXTURE_2D, 0);
-				}
-			}
+				const SpriteBatch::Batch& spriteBatch = batch.batches[i];
+				Shader* shader = spriteBatch.shader;
+				shader->use();
 
-			//Unbind vertex array
-			glBindVertexArray(0);
+				//The vertices are already in world space, instanced shaders don't use this
+				shader->SetMat4("model", glm::mat4(1.0f));
+
+				//UI elements are drawn with constant view and projection matrices
+				cameraBuffer->Use(shader, spriteBatch.uiElement ? CameraUniformBuffer::Slot::screen : CameraUniformBuffer::Slot::world);
+
+				//Bind the texture, nothing is sent to OpenGL if it is already bound
+				RenderState::Get()->BindTexture(0, spriteBatch.texture);
+
+				//Draw every sprite in the batch
+				batch.Draw(spriteBatch);
+			}
+			//Tilemap layers above every sprite
+			for (; nextTilemapDraw < tilemapDraws.size(); nextTilemapDraw++)
+				tilemap->draw(tilemapDraws[nextTilemapDraw].second);
 		}
 
 		//Set the screens clear color to given rgb
@@ -265,10 +326,70 @@ namespace engine
 			tilemap = map;
 		}
 
+		RenderMode renderMode = RenderMode::batched;
+
+		//Skip sprites outside the camera's view
+		bool frustumCulling = true;
+
+		//The grid used for culling, for drawing its cells with DebugDraw
+		const SpatialGrid& Grid() const
+		{
+			return grid;
+		}
+
 	private:
+		//Find the sprites the camera can see, UI elements are always visible
+		const vector<Entity>& VisibleSprites(Camera* cam)
+		{
+			visible.clear();
+			if (!frustumCulling)
+			{
+				visible.assign(entities.begin(), entities.end());
+				return visible;
+			}
+
+			for (const Entity& entity : entities)
+			{
+				SpriteRenderer& sprite = ecs.getComponent<SpriteRenderer>(entity);
+				if (sprite.uiElement)
+				{
+					grid.Remove(entity);
+					visible.push_back(entity);
+					continue;
+				}
+
+				//Only compute new bounds if the transform has changed
+				Transform& transform = ecs.getComponent<Transform>(entity);
+				TransformSystem::UpdateModelMatrix(transform);
+				if (grid.UpToDate(entity, transform.version))
+					continue;
+
+				//The quad goes from -1 to 1
+				grid.Update(entity, AABB{ glm::vec3(-1, -1, 0), glm::vec3(1, 1, 0) }.Transformed(transform.modelMatrix), transform.version);
+			}
+			grid.QueryVisible(cam->GetFrustum(), entities, visible);
+			return visible;
+		}
+
+		//The shader a sprite is drawn with. Sprites with a custom shader are always batched
+		Shader* SpriteShader(const SpriteRenderer& sprite)
+		{
+			if (sprite.shader)
+				return sprite.shader;
+			return renderMode == RenderMode::instanced ? instancedShader : defaultShader;
+		}
+
 		unsigned int VAO, VBO, EBO;
 		Shader* defaultShader;
+		Shader* instancedShader;
 		Tilemap* tilemap = nullptr;
+		SpriteBatch batch;
+		RenderQueue queue;
+		SpatialGrid grid;
+		vector<Entity> visible;
+		//Z of each queued tilemap layer, and the batch index each one is drawn before
+		vector<float> tilemapLayers;
+		vector<pair<unsigned int, float>> tilemapDraws;
 	};
 
 	//Animator system
@@ -310,7 +431,9 @@ namespace engine
 			SpriteRenderer& sprite = ecs.getComponent<SpriteRenderer>(entity);
 
 			//Change Sprites texture
-			sprite.texture = animator.animations[animator.currentAnimation].textures[animator.animationFrame];
+			const Animation& animation = animator.animations[animator.currentAnimation];
+			sprite.texture = animation.textures[animator.animationFrame];
+			sprite.uvRect = animation.uvRects.empty() ? glm::vec4(0, 0, 1, 1) : animation.uvRects[animator.animationFrame];
 
 			animator.animationFrame++;
 			animator.animationTimer = 0;
@@ -12,16 +12,36 @@
 #include <engine/GL/Shader.h>
 #include <engine/GL/Camera.h>
 #include <map>
+#include <unordered_map>
 #include <vector>
 
 using namespace std;
 
+namespace engine
+{
+	class Texture;
+	class TextureAtlas;
+}
+
+//A glyph packed into the glyph atlas
 struct Character
 {
-	unsigned int TextureID;
+	//The atlas page holding the glyph, null for glyphs without pixels such as space
+	engine::Texture* texture;
+	//Where the glyph is on the page, min x, min y, max x, max y in texture coordinates
+	glm::vec4 uvRect;
 	glm::ivec2 Size;
 	glm::ivec2 Bearing;
 	unsigned int Advance;
+	//The glyph's index in its face, used to look up kerning
+	FT_UInt glyphIndex;
+};
+
+//The glyphs of one face rasterized so far, by Unicode code point, and the face to rasterize the rest and look up kerning with
+struct FontStyle
+{
+	FT_Face face;
+	unordered_map<char32_t, Character> characters;
 };
 
 struct  TrueFont
@@ -34,6 +54,8 @@ struct  TrueFont
 
 namespace engine
 {
+	class TextLayout;
+
 	class TextRender
 	{
 	public:
@@ -53,26 +75,128 @@ namespace engine
 		void TexConfig();
 
 		// Text loading function
+		// Glyphs aren't rasterized here, each one is rasterized into the glyph atlas the first time it is drawn
 		void LoadText(vector<FT_Face> Faces);
 		
 		// Text Rendering function
+		// text is UTF-8. The whole string is uploaded at once and drawn with one draw call per atlas page it uses, usually one
 		void RenderText(string styleName, Camera* cam, string text, float x, float y, float scale, glm::vec3 colour);
 
+		// Draw many strings of one style and colour at once, each with its pen starting at its own position
+		// Much cheaper than calling RenderText for each of them, they are uploaded together and usually drawn with one draw call
+		void RenderTexts(string styleName, Camera* cam, const vector<pair<glm::vec2, string>>& texts, float scale, glm::vec3 colour);
+
+		//Counts up every time glyphs are evicted from the atlas, anything holding on to glyph quads must lay them out again when it changes
+		uint64_t GlyphGeneration() const
+		{
+			return glyphGeneration;
+		}
+
+		//How many atlas pages glyphs can use before the least recently drawn page is cleared to make room
+		//A single string needing more than this still gets its glyphs, the atlas grows instead
+		size_t maxGlyphPages = 4;
+
 	private:
-		map<GLchar, Character> Characters;
-		map<string, map<GLchar, Character>> StyleLinker;
+		friend class TextLayout;
+
+		//Build the quads of text with its pen starting at x, y, kerned if the face has kerning
+		//Call StartLayout before laying out the strings of one draw, so evicting glyphs for one of them can't clear a page another uses
+		//A new page draw is started whenever the atlas page changes. Returns the pen's x after the last glyph, or x if the style doesn't exist
+		float LayoutText(const string& styleName, const string& text, float x, float y, float scale, vector<float>& vertices, vector<pair<Texture*, unsigned int>>& pageDraws);
+
+		void StartLayout()
+		{
+			useStamp++;
+		}
+
+		//Upload vertices and draw them one page at a time
+		void DrawVertices(Camera* cam, glm::vec3 colour);
+
+		//Use the text shader with the camera, colour and transform for the next draws
+		void UseShader(Camera* cam, glm::vec3 colour, const glm::mat4& model);
+
+		//The glyph for codePoint, rasterized into the atlas if it isn't already. Null if the face can't render it
+		const Character* FindGlyph(FontStyle& style, char32_t codePoint);
+
+		//Clear the least recently drawn glyph page that isn't used by the string being laid out, returns false if there is none
+		bool EvictGlyphPage();
+
+		//Count page as drawn now so it is the last to be evicted
+		void MarkPageUsed(Texture* page)
+		{
+			pageLastUsed[page] = useStamp;
+		}
+
+		map<string, FontStyle> StyleLinker;
 
 		vector<FT_Face> Faces;
 
-		unsigned int VAO, VBO;
+		unsigned int VAO = 0, VBO = 0;
 
-		unsigned int texture;
+		//Every glyph of every face is packed into the atlas's pages
+		TextureAtlas* glyphAtlas;
 
-		FT_Library ft;
+		//When each glyph page was last drawn, pages with the lowest stamp are evicted first
+		unordered_map<Texture*, uint64_t> pageLastUsed;
+		uint64_t useStamp = 0;
+		uint64_t glyphGeneration = 0;
+
+		//Reused for converting FreeType's coverage bitmaps to RGBA
+		vector<unsigned char> glyphPixels;
+
+		//Reused between calls to RenderText so it doesn't allocate every frame
+		vector<float> vertices;
+		vector<pair<Texture*, unsigned int>> pageDraws;
 
-		glm::mat4 projection;
-		glm::mat4 viewMatrix;
+		FT_Library ft;
 
 		engine::Shader* m_shader;
 	};
-}
\ No newline at end of file
+
+	//A string laid out once and kept in its own buffer, for text that rarely changes such as labels, menus and scores
+	//Drawing it uploads nothing and is one draw call, the quads are only rebuilt when the text or scale changes,
+	//or when glyphs it uses were evicted from the glyph atlas
+	//The TextRender it uses must outlive it
+	class TextLayout
+	{
+	public:
+		TextLayout(TextRender* renderer, string styleName, string text = "", float scale = 1.0f);
+		~TextLayout();
+
+		TextLayout(const TextLayout&) = delete;
+		TextLayout& operator=(const TextLayout&) = delete;
+
+		//Change the text, nothing is rebuilt if it is the same as before
+		void SetText(const string& text);
+		void SetScale(float scale);
+
+		const string& Text() const
+		{
+			return text;
+		}
+
+		//How far the pen moves over the whole string, in pixels before the transform
+		float Width();
+
+		//Draw the text with its pen starting at x, y
+		void Draw(Camera* cam, float x, float y, glm::vec3 colour);
+		//Draw the text moved, rotated and scaled by transform, the pen starts at the transform's origin
+		void Draw(Camera* cam, const glm::mat4& transform, glm::vec3 colour);
+
+	private:
+		//Lay the text out again and upload it if it changed since the last time
+		void Build();
+
+		TextRender* renderer;
+		string styleName;
+		string text;
+		float scale;
+		float width = 0;
+		bool dirty = true;
+		//The renderer's glyph generation when this was laid out
+		uint64_t generation = 0;
+
+		unsigned int VAO = 0, VBO = 0;
+		vector<pair<Texture*, unsigned int>> pageDraws;
+	};
+}
@@ -0,0 +1,297 @@
+#pragma once
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <iostream>
+#include <glm/glm.hpp>
+#include <engine/GL/Texture.h>
+#include <engine/Sprite.h>
+#include <engine/Image.h>
+
+namespace engine
+{
+	//A part of a texture atlas page
+	struct AtlasRegion
+	{
+		Texture* texture = nullptr;
+		//min x, min y, max x, max y in texture coordinates, same as SpriteRenderer::uvRect
+		glm::vec4 uvRect = glm::vec4(0, 0, 1, 1);
+	};
+
+	//Packs many small images into a few large textures, so sprites using them can be batched into one draw call
+	//Images are placed with a skyline packer, when a page is full a new one is started
+	//The atlas owns its page textures, regions are valid as long as the atlas is
+	class TextureAtlas
+	{
+	public:
+		//padding is the empty space left around each image in pixels so neighbours don't bleed into each other when filtering
+		TextureAtlas(int pageWidth = 2048, int pageHeight = 2048, int padding = 1, unsigned int filteringType = GL_NEAREST)
+			: pageWidth(pageWidth), pageHeight(pageHeight), padding(padding), filteringType(filteringType) {}
+		~TextureAtlas()
+		{
+			for (Page& page : pages)
+				delete page.texture;
+		}
+
+		TextureAtlas(const TextureAtlas&) = delete;
+		TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+		//Load the image at path into the atlas
+		AtlasRegion Add(const char* path)
+		{
+			return Add(Image(path));
+		}
+
+		//Add a whole image, or a view of part of one, to the atlas
+		AtlasRegion Add(const ImageView& image)
+		{
+			return AddPixels((const unsigned char*)image.Data(), image.width, image.height, image.stride);
+		}
+
+		//Add the width by height rectangle of image whose top left corner is at x, y
+		AtlasRegion Add(const Image& image, int x, int y, int width, int height)
+		{
+			return Add(image.View(x, y, width, height));
+		}
+
+		//Add RGBA pixels going from the bottom row up, rowLength is how many pixels apart the rows are, 0 if they are tightly packed
+		AtlasRegion AddPixels(const unsigned char* pixels, int width, int height, int rowLength = 0)
+		{
+			AtlasRegion region;
+			if (TryAddPixels(pixels, width, height, region, rowLength))
+				return region;
+
+			int paddedWidth = width + padding * 2;
+			int paddedHeight = height + padding * 2;
+
+			//Images larger than a page get a page of their own
+			int newWidth = std::max(pageWidth, paddedWidth);
+			int newHeight = std::max(pageHeight, paddedHeight);
+			if (newWidth != pageWidth || newHeight != pageHeight)
+				std::cout << "Image of " << width << "x" << height << " is larger than the atlas pages, giving it its own page" << std::endl;
+
+			pages.push_back(Page(newWidth, newHeight, filteringType));
+			Page& page = pages.back();
+			int x = 0, y = 0;
+			page.Insert(paddedWidth, paddedHeight, x, y);
+			return Place(page, x, y, pixels, width, height, rowLength);
+		}
+
+		//Add RGBA pixels like AddPixels, but only to the pages the atlas already has
+		//Returns false and leaves region alone if none of them has room
+		bool TryAddPixels(const unsigned char* pixels, int width, int height, AtlasRegion& region, int rowLength = 0)
+		{
+			//Try every page, newest first since older pages are likely full
+			int x = 0, y = 0;
+			for (auto it = pages.rbegin(); it != pages.rend(); it++)
+			{
+				if (it->Insert(width + padding * 2, height + padding * 2, x, y))
+				{
+					region = Place(*it, x, y, pixels, width, height, rowLength);
+					return true;
+				}
+			}
+			return false;
+		}
+
+		//Empty the page using texture so it can be filled again, every region on it is no longer valid
+		//The texture itself is kept, returns false if it isn't one of this atlas's pages
+		bool ClearPage(Texture* texture)
+		{
+			for (Page& page : pages)
+			{
+				if (page.texture != texture)
+					continue;
+
+				page.skyline.assign(1, SkylineNode{ 0, 0, page.width });
+				//Clear the old pixels too, or they would bleed into the padding of whatever is added next
+				std::vector<unsigned char> empty((size_t)page.width * page.height * 4, 0);
+				page.texture->SetSubImage(0, 0, page.width, page.height, empty.data());
+				return true;
+			}
+			return false;
+		}
+
+		//How many textures the atlas has made so far
+		size_t PageCount() const
+		{
+			return pages.size();
+		}
+
+	private:
+		struct Page;
+
+		//Copy pixels into the padded spot at x, y of page
+		AtlasRegion Place(Page& page, int x, int y, const unsigned char* pixels, int width, int height, int rowLength)
+		{
+			x += padding;
+			y += padding;
+			page.texture->SetSubImage(x, y, width, height, pixels, rowLength);
+
+			AtlasRegion region;
+			region.texture = page.texture;
+			region.uvRect = glm::vec4((float)x / page.width, (float)y / page.height, (float)(x + width) / page.width, (float)(y + height) / page.height);
+			return region;
+		}
+
+		//One horizontal segment of the skyline
+		struct SkylineNode
+		{
+			int x, y, width;
+		};
+
+		struct Page
+		{
+			Page(int width, int height, unsigned int filteringType) : width(width), height(height)
+			{
+				texture = new Texture(width, height, filteringType);
+				skyline.push_back(SkylineNode{ 0, 0, width });
+			}
+
+			//Find room for a width by height rectangle, the lowest spot wins and ties go to the tightest fit
+			bool Insert(int rectWidth, int rectHeight, int& outX, int& outY)
+			{
+				int bestIndex = -1;
+				int bestTop = std::numeric_limits<int>::max();
+				int bestWidth = std::numeric_limits<int>::max();
+				int bestY = 0;
+
+				for (size_t i = 0; i < skyline.size(); i++)
+				{
+					int y = 0;
+					if (!Fits(i, rectWidth, rectHeight, y))
+						continue;
+
+					if (y + rectHeight < bestTop || (y + rectHeight == bestTop && skyline[i].width < bestWidth))
+					{
+						bestIndex = i;
+						bestTop = y + rectHeight;
+						bestWidth = skyline[i].width;
+						bestY = y;
+					}
+				}
+
+				if (bestIndex < 0)
+					return false;
+
+				outX = skyline[bestIndex].x;
+				outY = bestY;
+				AddSkylineLevel(bestIndex, outX, outY + rectHeight, rectWidth);
+				return true;
+			}
+
+			Texture* texture;
+			int width, height;
+			std::vector<SkylineNode> skyline;
+
+		private:
+			//Can the rectangle sit on the skyline starting at node index, y is set to the height it would rest at
+			bool Fits(size_t index, int rectWidth, int rectHeight, int& y) const
+			{
+				int x = skyline[index].x;
+				if (x + rectWidth > width)
+					return false;
+
+				//The rectangle rests on the highest node it spans
+				int widthLeft = rectWidth;
+				y = skyline[index].y;
+				while (widthLeft > 0)
+				{
+					y = std::max(y, skyline[index].y);
+					if (y + rectHeight > height)
+						return false;
+					widthLeft -= skyline[index].width;
+					index++;
+				}
+				return true;
+			}
+
+			//Raise the skyline under a newly placed rectangle
+			void AddSkylineLevel(size_t index, int x, int y, int levelWidth)
+			{
+				skyline.insert(skyline.begin() + index, SkylineNode{ x, y, levelWidth });
+
+				//Shrink or remove the nodes now covered by the new one
+				for (size_t i = index + 1; i < skyline.size(); i++)
+				{
+					int previousEnd = skyline[i - 1].x + skyline[i - 1].width;
+					if (skyline[i].x >= previousEnd)
+						break;
+
+					int shrink = previousEnd - skyline[i].x;
+					skyline[i].x += shrink;
+					skyline[i].width -= shrink;
+					if (skyline[i].width > 0)
+						break;
+
+					skyline.erase(skyline.begin() + i);
+					i--;
+				}
+
+				//Merge neighbours at the same height
+				for (size_t i = 0; i + 1 < skyline.size(); i++)
+				{
+					if (skyline[i].y == skyline[i + 1].y)
+					{
+						skyline[i].width += skyline[i + 1].width;
+						skyline.erase(skyline.begin() + i + 1);
+						i--;
+					}
+				}
+			}
+		};
+
+		int pageWidth, pageHeight;
+		int padding;
+		unsigned int filteringType;
+		std::vector<Page> pages;
+	};
+
+	//Slice a spritesheet into the atlas instead of separate textures, frames go from top-left to bottom-right
+	//spritesWide is how many sprites wide the spritesheet is and spritesHigh is how many sprites tall the spritesheet is
+	inline vector<AtlasRegion> SliceSpritesheet(TextureAtlas& atlas, const char* path, int spritesWide, int spritesHigh)
+	{
+		vector<AtlasRegion> regions;
+
+		Image spritesheet = Image(path);
+		const int width = spritesheet.width / spritesWide;
+		const int height = spritesheet.height / spritesHigh;
+
+		//Warn if the spritesheet is weirdly sized
+		if (spritesheet.width % spritesWide != 0 || spritesheet.height % spritesHigh != 0)
+			cout << "Spritesheet is not divisible by sprite count. Clipping may occur!";
+
+		for (int row = 0; row < spritesHigh; row++)
+			for (int col = 0; col < spritesWide; col++)
+				regions.push_back(atlas.Add(spritesheet, col * width, row * height, width, height));
+
+		return regions;
+	}
+
+	//Creates animations from a spritesheet sliced into the atlas, so every frame can be batched together
+	//Each row of sprites on the spritesheet becomes one animation.
+	//You must provide a vector of delays for each frame going from top-left to bottom-right
+	inline vector<Animation> AnimationsFromSpritesheet(TextureAtlas& atlas, const char* path, int spritesWide, int spritesHigh, vector<int> delays)
+	{
+		vector<AtlasRegion> allFrames = SliceSpritesheet(atlas, path, spritesWide, spritesHigh);
+
+		assert(allFrames.size() == delays.size() && "You must provide a delay for after each animation frame!");
+
+		vector<Animation> animations;
+		for (int i = 0; i < spritesHigh; i++)
+		{
+			vector<Texture*> textures;
+			vector<glm::vec4> uvRects;
+			for (int j = i * spritesWide; j < (i + 1) * spritesWide; j++)
+			{
+				textures.push_back(allFrames[j].texture);
+				uvRects.push_back(allFrames[j].uvRect);
+			}
+
+			vector<int> slicedDelays(delays.begin() + i * spritesWide, delays.begin() + (i + 1) * spritesWide);
+			animations.push_back(Animation(textures, uvRects, slicedDelays));
+		}
+
+		return animations;
+	}
+}
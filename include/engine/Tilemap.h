@@ -30,7 +30,14 @@ source distribution.
 #include <set>
 #include <map>
 #include <string>
+#include <thread>
+#include <atomic>
+#include <semaphore>
+#include <unordered_map>
+#include <unordered_set>
 #include <engine/MapLayer.h>
+#include <engine/MapChunks.h>
+#include <engine/BoundedQueue.h>
 #include <engine/GL/Texture.h>
 #include <engine/GL/Shader.h>
 #include <engine/GL/Camera.h>
@@ -42,16 +49,70 @@ public:
 	~Tilemap();
 	
 	void loadMap(const std::string ownMap);
+	//Load a map split by the MapChunker tool, its chunks are then loaded in the background as the camera gets near them
+	//and unloaded when it moves away, so the whole map is never in memory at once
+	void loadStreamingMap(const std::string& manifestPath);
 	void draw(float layer);
 
+	//Install chunks that finished loading, request the ones near the camera and unload far ones
+	//Called by draw once a frame, when drawing the lowest layer
+	void updateStreaming();
+
 	unsigned int checkCollision(float x, float y);
 
+	//Chunks of every layer, and how many of them the last draw of each layer drew
+	std::size_t chunkCount() const;
+	std::size_t visibleChunkCount() const;
+	//Chunks of a streaming map currently loaded, each has every layer of the map
+	std::size_t loadedChunkCount() const;
+
+	//Chunks are loaded this many pixels around the camera's view, and unloaded once streamDistance + unloadMargin away
+	//The margin keeps chunks at the edge from loading and unloading over and over as the camera moves back and forth
+	float streamDistance = 512.f;
+	float unloadMargin = 256.f;
+	//Most loaded chunks installed in one frame, each creates a lookup texture per layer and tileset it uses
+	unsigned int chunksPerFrame = 4;
+
 	tmx::Vector2u tileSize;
 	glm::vec3 position;
 	tmx::FloatRect bounds;
 
 	std::set<float> zLayers;
 private:
+	struct ChunkRequest final
+	{
+		std::uint64_t key = 0;
+		int x = 0, y = 0;
+	};
+
+	//A chunk read and prepared by the streaming thread, ready to be installed on the main thread
+	struct LoadedChunk final
+	{
+		std::uint64_t key = 0;
+		int x = 0, y = 0;
+		unsigned int width = 0, height = 0;
+		bool loaded = false;
+		//Lookups of every drawn layer, in the order of streamLayers
+		std::vector<std::vector<MapLayer::ChunkLookup>> lookups;
+		//Tile IDs of the collider layer row by row, empty if the map has none
+		std::vector<unsigned int> collision;
+	};
+
+	struct CollisionChunk final
+	{
+		unsigned int width = 0;
+		std::vector<unsigned int> tiles;
+	};
+
+	static std::uint64_t chunkKey(int x, int y);
+	void stopStreamingThread();
+	//Forget everything of the loaded map
+	void clearMap();
+	void initShader();
+	void streamChunks();
+	void installChunk(LoadedChunk&);
+	void unloadChunk(std::uint64_t key);
+
 	void initGLStuff(const tmx::Map&);
 	std::shared_ptr<engine::Texture> loadTexture(const std::string&);
 
@@ -63,4 +124,21 @@ private:
 	
 	engine::Shader* m_shader;
 	engine::Camera* camera;
+
+	//Streaming, manifest and tilesets are only written before the streaming thread starts
+	bool streaming = false;
+	std::string manifestPath;
+	engine::MapManifest manifest;
+	std::vector<MapLayer::TilesetRange> tilesetRanges;
+	std::vector<std::shared_ptr<MapLayer>> streamLayers;
+	std::unordered_map<std::uint64_t, CollisionChunk> collisionChunks;
+	std::unordered_set<std::uint64_t> loadedChunks;
+	//Requested and not installed yet, a result whose chunk was dropped from here in the meantime is thrown away
+	std::unordered_set<std::uint64_t> pendingChunks;
+
+	engine::BoundedQueue<ChunkRequest> chunkRequests{ 256 };
+	engine::BoundedQueue<LoadedChunk> chunkResults{ 64 };
+	std::counting_semaphore<> wakeStreaming{ 0 };
+	std::atomic<bool> stopStreaming{ false };
+	std::thread streamingThread;
 };
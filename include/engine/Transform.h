@@ -1,5 +1,13 @@
 #pragma once
 #include <glm/glm.hpp>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <algorithm>
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define ENGINE_TRANSFORM_SSE
+#include <xmmintrin.h>
+#endif
 #include <engine/ECSCore.h>
 #include <engine/Vector.h>
 
@@ -7,6 +15,9 @@ extern ECS ecs;
 
 namespace engine
 {
+	//Entity id which never refers to an entity
+	const Entity NULL_ENTITY = std::numeric_limits<Entity>::max();
+
 	//Transform component
 	struct Transform
 	{
@@ -16,6 +27,35 @@ namespace engine
 
 		//If true updates all transform based caches, reverts to false after that is done
 		bool staleCache = false;
+
+		//Cached model matrix, read it through TransformSystem::GetModelMatrix
+		glm::mat4 modelMatrix = glm::mat4(1.0f);
+		//Changes every time the model matrix is rebuilt, so other caches can tell when the transform has moved
+		unsigned int version = 0;
+		//The values the model matrix was built from, position, rotation, and scale are often written directly so these are compared too
+		Vector3 builtPosition = Vector3(std::numeric_limits<float>::quiet_NaN());
+		Vector3 builtRotation;
+		Vector3 builtScale;
+
+		//Set for transforms with a parent, their position, rotation, and scale are relative to the parent
+		//The model matrix is then the parent's model matrix times the local matrix
+		bool parented = false;
+		glm::mat4 localMatrix = glm::mat4(1.0f);
+		//True if the local matrix has changed since the model matrix was built
+		bool worldStale = false;
+		//The parent's version when the model matrix was built
+		unsigned int parentVersion = 0;
+	};
+
+	//Hierarchy component, links an entity to its parent and children
+	//It is added and kept up to date by TransformSystem::SetParent, don't modify it directly
+	struct Hierarchy
+	{
+		Entity parent = NULL_ENTITY;
+		Entity firstChild = NULL_ENTITY;
+		Entity nextSibling = NULL_ENTITY;
+		//How many parents are above this entity
+		uint16_t depth = 0;
 	};
 
 	//Transform system
@@ -23,13 +63,220 @@ namespace engine
 	class TransformSystem : public System
 	{
 	public:
-		//No update functionality yet
+		//Rebuild the model matrices of every transform which has changed since the last update
+		//Then propagate parents' model matrices to their children, only touching the subtrees which changed
 		void Update()
 		{
 			for (auto const& entity : entities)
 			{
+				UpdateModelMatrix(ecs.getComponent<Transform>(entity));
+			}
+
+			if (hierarchyChanged)
+				RebuildHierarchy();
+
+			//Parents are always before their children, so one pass is enough
+			for (const HierarchyLink& link : hierarchyOrder)
+			{
+				//The Hierarchy of the parent or child was removed, fix the hierarchy on the next update
+				//Destroyed entities are unlinked right away by OnEntityDestroyed
+				if (!ecs.hasComponent<Hierarchy>(link.entity) || !ecs.hasComponent<Hierarchy>(link.parent))
+				{
+					hierarchyChanged = true;
+					continue;
+				}
+
+				Transform& transform = ecs.getComponent<Transform>(link.entity);
+				Transform& parent = ecs.getComponent<Transform>(link.parent);
+				if (!transform.worldStale && transform.parentVersion == parent.version)
+					continue;
+
+				transform.modelMatrix = parent.modelMatrix * transform.localMatrix;
+				transform.parentVersion = parent.version;
+				transform.worldStale = false;
+				transform.version = ++VersionCounter();
+			}
+		}
+
+		//Get the model matrix of transform, it is only rebuilt if the transform has changed
+		//For entities with a parent this is the matrix from the last Update()
+		static const glm::mat4& GetModelMatrix(Transform& transform)
+		{
+			UpdateModelMatrix(transform);
+			return transform.modelMatrix;
+		}
+
+		//Rebuild the model matrix, or the local matrix of entities with a parent, if the transform is stale. Returns true if it was rebuilt
+		static bool UpdateModelMatrix(Transform& transform)
+		{
+			if (!transform.staleCache && SameValues(transform.position, transform.builtPosition) && SameValues(transform.rotation, transform.builtRotation) && SameValues(transform.scale, transform.builtScale))
+				return false;
+
+			glm::mat4 matrix = ComposeMatrix(transform.position.ToGlm(), transform.rotation.ToGlm(), transform.scale.ToGlm());
+			transform.builtPosition = transform.position;
+			transform.builtRotation = transform.rotation;
+			transform.builtScale = transform.scale;
+			transform.staleCache = false;
 
+			if (transform.parented)
+			{
+				transform.localMatrix = matrix;
+				transform.worldStale = true;
+			}
+			else
+			{
+				transform.modelMatrix = matrix;
+				transform.version = ++VersionCounter();
 			}
+			return true;
+		}
+
+		//Attach child to parent, after which child's transform is relative to parent's. Give NULL_ENTITY as the parent to detach it
+		//Both entities need a Transform, the Hierarchy component is added as needed
+		void SetParent(Entity child, Entity parent)
+		{
+			assert(child != parent && "An entity can't be its own parent!");
+
+			if (!ecs.hasComponent<Hierarchy>(child))
+				ecs.addComponent(child, Hierarchy{});
+			if (parent != NULL_ENTITY && !ecs.hasComponent<Hierarchy>(parent))
+				ecs.addComponent(parent, Hierarchy{});
+
+			//Parenting to one of its own descendants would make a loop
+			for (Entity ancestor = parent; ancestor != NULL_ENTITY; ancestor = ecs.getComponent<Hierarchy>(ancestor).parent)
+			{
+				if (ancestor == child)
+				{
+					assert(false && "Can't parent an entity to its own descendant!");
+					return;
+				}
+			}
+
+			Hierarchy& hierarchy = ecs.getComponent<Hierarchy>(child);
+			if (hierarchy.parent == parent)
+				return;
+
+			Unlink(child, hierarchy);
+			hierarchy.parent = parent;
+			if (parent != NULL_ENTITY)
+			{
+				Hierarchy& parentHierarchy = ecs.getComponent<Hierarchy>(parent);
+				hierarchy.nextSibling = parentHierarchy.firstChild;
+				parentHierarchy.firstChild = child;
+			}
+
+			//Rebuild the matrix in the right space
+			Transform& transform = ecs.getComponent<Transform>(child);
+			transform.parented = parent != NULL_ENTITY;
+			transform.staleCache = true;
+			transform.worldStale = true;
+			hierarchyChanged = true;
+		}
+
+		//Detach a destroyed entity's children and take it out of its parent's children right away,
+		//so a new entity given the same id later isn't mistaken for it
+		void OnEntityDestroyed(Entity entity) override
+		{
+			if (!ecs.hasComponent<Hierarchy>(entity))
+				return;
+
+			Hierarchy& hierarchy = ecs.getComponent<Hierarchy>(entity);
+			Entity child = hierarchy.firstChild;
+			while (child != NULL_ENTITY)
+			{
+				Hierarchy& childHierarchy = ecs.getComponent<Hierarchy>(child);
+				Entity next = childHierarchy.nextSibling;
+				childHierarchy.parent = NULL_ENTITY;
+				childHierarchy.nextSibling = NULL_ENTITY;
+
+				Transform& transform = ecs.getComponent<Transform>(child);
+				transform.parented = false;
+				transform.staleCache = true;
+				UpdateModelMatrix(transform);
+				child = next;
+			}
+			hierarchy.firstChild = NULL_ENTITY;
+
+			Unlink(entity, hierarchy);
+			hierarchyChanged = true;
+		}
+
+		//Get the parent of entity, or NULL_ENTITY if it has none
+		static Entity GetParent(Entity entity)
+		{
+			if (!ecs.hasComponent<Hierarchy>(entity))
+				return NULL_ENTITY;
+			return ecs.getComponent<Hierarchy>(entity).parent;
+		}
+
+		//Get the direct children of entity
+		static std::vector<Entity> GetChildren(Entity entity)
+		{
+			std::vector<Entity> children;
+			if (!ecs.hasComponent<Hierarchy>(entity))
+				return children;
+
+			for (Entity child = ecs.getComponent<Hierarchy>(entity).firstChild; child != NULL_ENTITY; child = ecs.getComponent<Hierarchy>(child).nextSibling)
+				children.push_back(child);
+			return children;
+		}
+
+		//Build translate * rotateX * rotateY * rotateZ * scale, rotation is in degrees
+		//Equal to the glm::translate, glm::rotate, and glm::scale chain but without the matrix multiplications
+		static glm::mat4 ComposeMatrix(glm::vec3 position, glm::vec3 rotation, glm::vec3 scale)
+		{
+			glm::vec3 radians = glm::radians(rotation);
+			float sx = std::sin(radians.x), cx = std::cos(radians.x);
+			float sy = std::sin(radians.y), cy = std::cos(radians.y);
+			float sz = std::sin(radians.z), cz = std::cos(radians.z);
+
+			//The first two columns of the rotation are both combinations of u and v
+			glm::mat4 matrix;
+#ifdef ENGINE_TRANSFORM_SSE
+			__m128 u = _mm_setr_ps(cy, sx * sy, -cx * sy, 0);
+			__m128 v = _mm_setr_ps(0, cx, sx, 0);
+			__m128 column0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(cz), u), _mm_mul_ps(_mm_set1_ps(sz), v));
+			__m128 column1 = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(cz), v), _mm_mul_ps(_mm_set1_ps(sz), u));
+			__m128 column2 = _mm_setr_ps(sy, -sx * cy, cx * cy, 0);
+
+			_mm_storeu_ps(&matrix[0][0], _mm_mul_ps(column0, _mm_set1_ps(scale.x)));
+			_mm_storeu_ps(&matrix[1][0], _mm_mul_ps(column1, _mm_set1_ps(scale.y)));
+			_mm_storeu_ps(&matrix[2][0], _mm_mul_ps(column2, _mm_set1_ps(scale.z)));
+			_mm_storeu_ps(&matrix[3][0], _mm_setr_ps(position.x, position.y, position.z, 1));
+#else
+			glm::vec4 u(cy, sx * sy, -cx * sy, 0);
+			glm::vec4 v(0, cx, sx, 0);
+			matrix[0] = (cz * u + sz * v) * scale.x;
+			matrix[1] = (cz * v - sz * u) * scale.y;
+			matrix[2] = glm::vec4(sy, -sx * cy, cx * cy, 0) * scale.z;
+			matrix[3] = glm::vec4(position, 1);
+#endif
+			return matrix;
+		}
+
+		//Rotate an entity by dx, dy, and dz degrees
+		static void Rotate(Entity entity, float dx, float dy, float dz)
+		{
+			Transform& transform = ecs.getComponent<Transform>(entity);
+			transform.rotation.x += dx;
+			transform.rotation.y += dy;
+			transform.rotation.z += dz;
+			transform.staleCache = true;
+		}
+		//Set the absolute rotation of entity in degrees
+		static void SetRotation(Entity entity, Vector3 rotation)
+		{
+			Transform& transform = ecs.getComponent<Transform>(entity);
+			transform.rotation = rotation;
+			transform.staleCache = true;
+		}
+
+		//Set the absolute scale of entity
+		static void SetScale(Entity entity, Vector3 scale)
+		{
+			Transform& transform = ecs.getComponent<Transform>(entity);
+			transform.scale = scale;
+			transform.staleCache = true;
 		}
 
 		//Translate an entity by dx, dy, and dz
@@ -39,12 +286,14 @@ namespace engine
 			transform.position.x += dx;
 			transform.position.y += dy;
 			transform.position.z += dz;
+			transform.staleCache = true;
 		}
 		//Translate an entity by dt
 		static void Translate(Entity entity, Vector3 dt)
 		{
 			Transform& transform = ecs.getComponent<Transform>(entity);
 			transform.position += dt;
+			transform.staleCache = true;
 		}
 
 		//Set the absolute position of entity
@@ -54,12 +303,14 @@ namespace engine
 			transform.position.x = x;
 			transform.position.y = y;
 			transform.position.z = z;
+			transform.staleCache = true;
 		}
 		//Set the absolute position of entity
 		static void SetPosition(Entity entity, Vector3 position)
 		{
 			Transform& transform = ecs.getComponent<Transform>(entity);
 			transform.position = position;
+			transform.staleCache = true;
 		}
 		//Get the distance between two entities
 		static float Distance(Entity a, Entity b)
@@ -79,5 +330,124 @@ namespace engine
 
 			return glm::degrees(atan2(bTransform.position.y - aTransform.position.y, bTransform.position.x - aTransform.position.x));
 		}
+
+	private:
+		//A child and its parent, stored together so the propagation pass doesn't need to look up the hierarchy
+		struct HierarchyLink
+		{
+			Entity entity;
+			Entity parent;
+		};
+
+		//Remove entity from its parent's list of children
+		void Unlink(Entity entity, Hierarchy& hierarchy)
+		{
+			if (hierarchy.parent == NULL_ENTITY)
+				return;
+
+			Hierarchy& parentHierarchy = ecs.getComponent<Hierarchy>(hierarchy.parent);
+			if (parentHierarchy.firstChild == entity)
+			{
+				parentHierarchy.firstChild = hierarchy.nextSibling;
+			}
+			else
+			{
+				Entity sibling = parentHierarchy.firstChild;
+				while (sibling != NULL_ENTITY)
+				{
+					Hierarchy& siblingHierarchy = ecs.getComponent<Hierarchy>(sibling);
+					if (siblingHierarchy.nextSibling == entity)
+					{
+						siblingHierarchy.nextSibling = hierarchy.nextSibling;
+						break;
+					}
+					sibling = siblingHierarchy.nextSibling;
+				}
+			}
+			hierarchy.parent = NULL_ENTITY;
+			hierarchy.nextSibling = NULL_ENTITY;
+		}
+
+		//Rebuild the depth sorted list of every entity with a parent, and relink the children lists from the parents
+		//Entities whose parent lost its Hierarchy are detached. Only done when the hierarchy has changed
+		void RebuildHierarchy()
+		{
+			hierarchyChanged = false;
+			hierarchyOrder.clear();
+
+			std::vector<Entity> members;
+			for (const Entity& entity : entities)
+			{
+				if (!ecs.hasComponent<Hierarchy>(entity))
+					continue;
+
+				Hierarchy& hierarchy = ecs.getComponent<Hierarchy>(entity);
+				hierarchy.firstChild = NULL_ENTITY;
+				hierarchy.nextSibling = NULL_ENTITY;
+				hierarchy.depth = 0;
+				members.push_back(entity);
+
+				if (hierarchy.parent != NULL_ENTITY && !ecs.hasComponent<Hierarchy>(hierarchy.parent))
+				{
+					hierarchy.parent = NULL_ENTITY;
+					Transform& transform = ecs.getComponent<Transform>(entity);
+					transform.parented = false;
+					transform.staleCache = true;
+					UpdateModelMatrix(transform);
+				}
+			}
+
+			//Relink the children and find the depth of each entity by walking up its parents
+			uint16_t maxDepth = 0;
+			for (Entity entity : members)
+			{
+				Hierarchy& hierarchy = ecs.getComponent<Hierarchy>(entity);
+				if (hierarchy.parent == NULL_ENTITY)
+					continue;
+
+				Hierarchy& parentHierarchy = ecs.getComponent<Hierarchy>(hierarchy.parent);
+				hierarchy.nextSibling = parentHierarchy.firstChild;
+				parentHierarchy.firstChild = entity;
+
+				for (Entity ancestor = hierarchy.parent; ancestor != NULL_ENTITY; ancestor = ecs.getComponent<Hierarchy>(ancestor).parent)
+					hierarchy.depth++;
+				maxDepth = std::max(maxDepth, hierarchy.depth);
+			}
+
+			//Counting sort by depth so every parent comes before its children
+			std::vector<unsigned int> depthStart(maxDepth + 2, 0);
+			for (Entity entity : members)
+				depthStart[ecs.getComponent<Hierarchy>(entity).depth + 1]++;
+			for (size_t i = 1; i < depthStart.size(); i++)
+				depthStart[i] += depthStart[i - 1];
+
+			//Roots aren't stored, they have nothing to propagate from
+			std::vector<HierarchyLink> sorted(members.size());
+			for (Entity entity : members)
+			{
+				Hierarchy& hierarchy = ecs.getComponent<Hierarchy>(entity);
+				sorted[depthStart[hierarchy.depth]++] = HierarchyLink{ entity, hierarchy.parent };
+			}
+			for (const HierarchyLink& link : sorted)
+			{
+				if (link.parent != NULL_ENTITY)
+					hierarchyOrder.push_back(link);
+			}
+		}
+
+		bool hierarchyChanged = false;
+		std::vector<HierarchyLink> hierarchyOrder;
+
+		static bool SameValues(const Vector3& a, const Vector3& b)
+		{
+			return a.x == b.x && a.y == b.y && a.z == b.z;
+		}
+
+		//Source of transform versions, shared by every transform so a version is never reused
+		static unsigned int& VersionCounter()
+		{
+			static unsigned int counter = 0;
+			return counter;
+		}
 	};
 }
\ No newline at end of file
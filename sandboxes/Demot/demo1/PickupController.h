@@ -25,8 +25,8 @@ class PickupController : public System
 public:
 	PickupController()
 	{
-		defaultTexture = new Texture("assets/strawberry.png");
-		winner = new Texture("assets/winner.png");
+		defaultTexture = AssetManager::Get()->Load<Texture>("assets/strawberry.png");
+		winner = AssetManager::Get()->Load<Texture>("assets/winner.png");
 		animations = AnimationsFromSpritesheet("assets/Strawberry Animation.png", 7, 2, vector<int>(7 * 2, 100));
 		//scoreAnims = AnimationsFromSpritesheet("assets/");
 		winScreen = ecs.newEntity();
@@ -101,10 +101,10 @@ public:
 	}
 
 	Entity winScreen;
-	Texture* winner;
+	AssetHandle<Texture> winner;
 	vector<Animation> scoreAnims;
 	vector<Animation> animations;
-	Texture* defaultTexture;
+	AssetHandle<Texture> defaultTexture;
 	int collected = 0;
 	int total = 0;
 };
\ No newline at end of file
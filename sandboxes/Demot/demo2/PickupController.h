@@ -19,8 +19,8 @@ class PickupController : public System
 public:
 	PickupController()
 	{
-		defaultTexture = new Texture("assets/ammo box.png");
-		winner = new Texture("assets/winner.png");
+		defaultTexture = AssetManager::Get()->Load<Texture>("assets/ammo box.png");
+		winner = AssetManager::Get()->Load<Texture>("assets/winner.png");
 
 		winScreen = ecs.newEntity();
 		ecs.addComponent(winScreen, Transform{ .position = Vector3(0, 0, 20), .scale = Vector3(200, 200, 0) });
@@ -65,8 +65,8 @@ public:
 	}
 
 	Entity winScreen;
-	Texture* winner;
-	Texture* defaultTexture;
+	AssetHandle<Texture> winner;
+	AssetHandle<Texture> defaultTexture;
 	int collected = 0;
 	int total = 0;
 };
\ No newline at end of file
@@ -76,8 +76,8 @@ public:
 	TurretController()
 	{
 		explosion = AnimationsFromSpritesheet("assets/explosion.png", 5, 1, vector<int>(5, 75))[0];
-		defaultTexture = new Texture("assets/Gun_06.png");
-		projectileTexture = new Texture("assets/bullet.png");
+		defaultTexture = AssetManager::Get()->Load<Texture>("assets/Gun_06.png");
+		projectileTexture = AssetManager::Get()->Load<Texture>("assets/bullet.png");
 
 		//Register Projectile Controller
 		ecs.registerComponent<Projectile>();
@@ -162,6 +162,6 @@ public:
 	Entity player;
 	Animation explosion;
 	shared_ptr<ProjectileController> projectileController;
-	Texture* defaultTexture;
-	Texture* projectileTexture;
+	AssetHandle<Texture> defaultTexture;
+	AssetHandle<Texture> projectileTexture;
 };
\ No newline at end of file
@@ -30,39 +30,33 @@ source distribution.
 #include <tmxlite/TileLayer.hpp>
 #include <engine/GL/Texture.h>
 #include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
 
 //MapLayer::MapLayer(const tmx::Map& map, std::size_t layerIdx, const std::vector<std::shared_ptr<engine::Texture>>& textures, unsigned int tileSize) : m_allTextures(textures), tileSize(tileSize)
 MapLayer::MapLayer(const tmx::Map& map, std::size_t layerIdx, const std::vector<std::shared_ptr<engine::Texture>>& textures) : m_allTextures(textures)
 {
-    glGenVertexArrays(1, &VAO);
-    glBindVertexArray(VAO);
-
-
-    createSubsets(map, layerIdx);
-    /*
-    const auto mapSize = map.getTileCount();
-    unsigned int mapSizeUInt = static_cast<unsigned int>(mapSize.x * mapSize.y);
+    createVertexArray();
+    createChunks(map, layerIdx);
+}
 
-    createSubsets(map, layerIdx, mapSizeUInt);
-    */
+MapLayer::MapLayer(const std::vector<std::shared_ptr<engine::Texture>>& textures) : m_allTextures(textures)
+{
+    createVertexArray();
 }
 
 MapLayer::~MapLayer()
 {
-    for(auto& ss : m_subsets)
-    {
-        if(ss.vbo)
-        {
-            glDeleteBuffers(1, &ss.vbo);
-        }
-        //don't delete the tileset textures as these are
-        //shared and deleted elsewhere
-    }
+    engine::RenderState::Get()->DeleteVertexArray(VAO);
+    engine::RenderState::Get()->DeleteBuffer(VBO);
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    //don't delete the tileset textures as these are
+    //shared and deleted elsewhere
 }
 
 //public
 //void MapLayer::draw(glm::mat4 model, unsigned int modelLoc, unsigned int tilesetCountLoc, unsigned int tileSizeLoc)
-void MapLayer::draw(glm::mat4 model, unsigned int modelLoc, unsigned int tilesetCountLoc, unsigned int tileSizeLoc)
+void MapLayer::draw(glm::mat4 model, unsigned int modelLoc, unsigned int tilesetCountLoc, unsigned int tileSizeLoc, const engine::Frustum& frustum)
 {
     model = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, zLayer));
     model = glm::rotate(model, (float)M_PI, glm::vec3(1.0f, 0.0f, 0.0f));
@@ -70,79 +64,48 @@ void MapLayer::draw(glm::mat4 model, unsigned int modelLoc, unsigned int tileset
 
     glUniform2f(tileSizeLoc, tileSize.x, tileSize.y);
 
-    glBindVertexArray(VAO);
+    engine::RenderState::Get()->BindVertexArray(VAO);
 
-    glEnableVertexAttribArray(0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), 0);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-    
-    for(const auto& ss : m_subsets)
+    visibleChunks = 0;
+    for (const auto& chunk : m_chunks)
     {
-        glUniform2f(tilesetCountLoc, ss.sx, ss.sy);
-
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, ss.texture->ID());
-        
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, ss.lookup->ID());
-        
-        glBindBuffer(GL_ARRAY_BUFFER, ss.vbo);
-        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-    }
-    
-    glDisableVertexAttribArray(0);
-    glDisableVertexAttribArray(1);
+        if (!frustum.Intersects(chunk.bounds.Transformed(model)))
+            continue;
+        visibleChunks++;
+
+        for (const auto& ss : chunk.subsets)
+        {
+            glUniform2f(tilesetCountLoc, ss.sx, ss.sy);
+
+            ss.texture->Use(0);
+            ss.lookup->Use(1);
 
-    glBindVertexArray(0);
+            glDrawArrays(GL_TRIANGLE_STRIP, chunk.slot * 4, 4);
+        }
+    }
 }
 
-//private
-//void MapLayer::createSubsets(const tmx::Map& map, std::size_t layerIdx, unsigned int mapSizeUInt)
-void MapLayer::createSubsets(const tmx::Map& map, std::size_t layerIdx)
+std::vector<MapLayer::ChunkLookup> MapLayer::buildLookups(const tmx::TileLayer::Tile* tiles, std::size_t rowStride, unsigned int width, unsigned int height, const std::vector<TilesetRange>& tilesets)
 {
-    const auto& layers = map.getLayers();
-    if(layerIdx >= layers.size() || (layers[layerIdx]->getType() != tmx::Layer::Type::Tile))
-    {
-        std::cout << "Invalid layer index or layer type, layer will be empty" << std::endl;
-        return;
-    }
-    const auto layer = dynamic_cast<const tmx::TileLayer*>(layers[layerIdx].get());
-    
-    auto bounds = map.getBounds();
-    float verts[] = 
-    {
-      bounds.left, bounds.top, 0.f, 0.f, 0.f,
-      bounds.left + bounds.width, bounds.top, 0.f, 1.f, 0.f,
-      bounds.left, bounds.top + bounds.height, 0.f, 0.f, 1.f,
-      bounds.left + bounds.width, bounds.top + bounds.height, 0.f, 1.f, 1.f
-    };
-    
-    const auto& mapSize = map.getTileCount();
-    const auto& tilesets = map.getTilesets();
+    std::vector<ChunkLookup> lookups;
     for(auto i = 0u; i < tilesets.size(); ++i)
-    {        
+    {
         //check each tile ID to see if it falls in the current tile set
         const auto& ts = tilesets[i];
-        int numRows = ts.getTileCount() / ts.getColumnCount();
-        int numCols = ts.getColumnCount();
-        const auto& tileIDs = layer->getTiles();
         std::vector<std::uint16_t> pixelData;
         bool tsUsed = false;
-        
-        for(auto y = 0u; y < mapSize.y; ++y)
+
+        for(auto y = 0u; y < height; ++y)
         {
-            for(auto x = 0u; x < mapSize.x; ++x)
+            for(auto x = 0u; x < width; ++x)
             {
-               auto idx = y * mapSize.x + x;
-               if (idx < tileIDs.size() && tileIDs[idx].ID >= ts.getFirstGID()
-                    && tileIDs[idx].ID < (ts.getFirstGID() + ts.getTileCount()))
-                {      
-                   auto id = tileIDs[idx].ID - ts.getFirstGID() + 1;
+               const auto& tile = tiles[y * rowStride + x];
+               if (tile.ID >= ts.firstGID && tile.ID < (ts.firstGID + ts.tileCount))
+                {
+                   auto id = tile.ID - ts.firstGID + 1;
                    pixelData.push_back(static_cast<std::uint16_t>(id)); //red channel - making sure to index relative to the tileset
-                   pixelData.push_back(static_cast<std::uint16_t>(tileIDs[idx].flipFlags)); //green channel - tile flips are performed on the shader
+                   pixelData.push_back(static_cast<std::uint16_t>(tile.flipFlags)); //green channel - tile flips are performed on the shader
                     tsUsed = true;
-
                 }
                 else
                 {
@@ -152,19 +115,146 @@ void MapLayer::createSubsets(const tmx::Map& map, std::size_t layerIdx)
                 }
             }
         }
-        
-        //if we have some data for this tile set, create the resources
+
         if(tsUsed)
+            lookups.push_back(ChunkLookup{ i, std::move(pixelData) });
+    }
+    return lookups;
+}
+
+void MapLayer::addChunk(std::uint64_t key, glm::vec4 rect, unsigned int width, unsigned int height, const std::vector<ChunkLookup>& lookups, const std::vector<TilesetRange>& tilesets)
+{
+    //Nothing to draw in an empty chunk
+    if (lookups.empty())
+        return;
+
+    Chunk chunk;
+    chunk.key = key;
+    for (const auto& lookup : lookups)
+    {
+        const auto& ts = tilesets[lookup.tileset];
+        chunk.subsets.emplace_back();
+        chunk.subsets.back().sx = ts.columns;
+        chunk.subsets.back().sy = ts.tileCount / ts.columns;
+        chunk.subsets.back().texture = m_allTextures[lookup.tileset];
+        chunk.subsets.back().lookup = std::make_shared<engine::Texture>(width, height, lookup.pixelData);
+    }
+
+    //The quad covers only the chunk's tiles, its texture coordinates go over the chunk's lookup textures
+    const float left = rect.x, top = rect.y, right = rect.z, bottom = rect.w;
+    const float quad[] =
+    {
+        left, top, 0.f, 0.f, 0.f,
+        right, top, 0.f, 1.f, 0.f,
+        left, bottom, 0.f, 0.f, 1.f,
+        right, bottom, 0.f, 1.f, 1.f
+    };
+    chunk.bounds.Expand(glm::vec3(left, top, 0.f));
+    chunk.bounds.Expand(glm::vec3(right, bottom, 0.f));
+
+    const std::size_t slotFloats = sizeof(quad) / sizeof(float);
+    engine::RenderState::Get()->BindBuffer(GL_ARRAY_BUFFER, VBO);
+    if (!m_freeSlots.empty())
+    {
+        //Reuse the slot of a removed chunk
+        chunk.slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+        std::copy(std::begin(quad), std::end(quad), m_verts.begin() + chunk.slot * slotFloats);
+        glBufferSubData(GL_ARRAY_BUFFER, chunk.slot * sizeof(quad), sizeof(quad), quad);
+    }
+    else
+    {
+        chunk.slot = m_verts.size() / slotFloats;
+        m_verts.insert(m_verts.end(), std::begin(quad), std::end(quad));
+        //createChunks uploads every quad at once when it's done
+        if (!m_deferUpload && m_verts.size() > m_bufferFloats)
+        {
+            //Grow the buffer, doubling so the whole of it is only uploaded again every so often
+            m_bufferFloats = std::max(m_verts.size(), m_bufferFloats * 2);
+            glBufferData(GL_ARRAY_BUFFER, m_bufferFloats * sizeof(float), nullptr, GL_STATIC_DRAW);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, m_verts.size() * sizeof(float), m_verts.data());
+        }
+        else if (!m_deferUpload)
+        {
+            //Only the new quad, the rest of the buffer is already up to date
+            glBufferSubData(GL_ARRAY_BUFFER, chunk.slot * sizeof(quad), sizeof(quad), quad);
+        }
+    }
+
+    m_chunks.push_back(std::move(chunk));
+}
+
+void MapLayer::removeChunk(std::uint64_t key)
+{
+    auto it = std::find_if(m_chunks.begin(), m_chunks.end(), [key](const Chunk& chunk) { return chunk.key == key; });
+    if (it == m_chunks.end())
+        return;
+
+    m_freeSlots.push_back(it->slot);
+    //Draw order between chunks doesn't matter, they don't overlap
+    *it = std::move(m_chunks.back());
+    m_chunks.pop_back();
+}
+
+//private
+void MapLayer::createVertexArray()
+{
+    //The vertex layout never changes, so it is configured once here instead of every draw
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    engine::RenderState::Get()->BindVertexArray(VAO);
+    engine::RenderState::Get()->BindBuffer(GL_ARRAY_BUFFER, VBO);
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), 0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+}
+
+void MapLayer::createChunks(const tmx::Map& map, std::size_t layerIdx)
+{
+    const auto& layers = map.getLayers();
+    if(layerIdx >= layers.size() || (layers[layerIdx]->getType() != tmx::Layer::Type::Tile))
+    {
+        std::cout << "Invalid layer index or layer type, layer will be empty" << std::endl;
+        return;
+    }
+    const auto layer = dynamic_cast<const tmx::TileLayer*>(layers[layerIdx].get());
+    const auto& tileIDs = layer->getTiles();
+
+    const auto& mapSize = map.getTileCount();
+    const auto& mapTileSize = map.getTileSize();
+    const auto bounds = map.getBounds();
+    if (tileIDs.size() < (std::size_t)mapSize.x * mapSize.y)
+    {
+        std::cout << "Layer has fewer tiles than the map, layer will be empty" << std::endl;
+        return;
+    }
+
+    std::vector<TilesetRange> tilesets;
+    for (const auto& ts : map.getTilesets())
+        tilesets.push_back(TilesetRange{ ts.getFirstGID(), ts.getTileCount(), ts.getColumnCount() });
+
+    //Every quad of the map is known up front, so they are uploaded in one go after the loop
+    m_deferUpload = true;
+    std::uint64_t key = 0;
+    for (auto chunkY = 0u; chunkY < mapSize.y; chunkY += CHUNK_SIZE)
+    {
+        for (auto chunkX = 0u; chunkX < mapSize.x; chunkX += CHUNK_SIZE)
         {
-            m_subsets.emplace_back();
-            m_subsets.back().sx = numCols;
-            m_subsets.back().sy = numRows;
-            m_subsets.back().texture = m_allTextures[i];
-            m_subsets.back().lookup = std::make_shared<engine::Texture>(mapSize.x, mapSize.y, pixelData);
-     
-            glGenBuffers(1, &m_subsets.back().vbo);
-            glBindBuffer(GL_ARRAY_BUFFER, m_subsets.back().vbo);
-            glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW);
+            //Chunks on the right and bottom edges are cut to the map
+            const auto width = std::min(CHUNK_SIZE, mapSize.x - chunkX);
+            const auto height = std::min(CHUNK_SIZE, mapSize.y - chunkY);
+            const auto lookups = buildLookups(&tileIDs[chunkY * mapSize.x + chunkX], mapSize.x, width, height, tilesets);
+
+            const float left = bounds.left + chunkX * mapTileSize.x;
+            const float top = bounds.top + chunkY * mapTileSize.y;
+            addChunk(key++, glm::vec4(left, top, left + width * mapTileSize.x, top + height * mapTileSize.y), width, height, lookups, tilesets);
         }
-    }    
+    }
+    m_deferUpload = false;
+
+    m_bufferFloats = m_verts.size();
+    engine::RenderState::Get()->BindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, m_verts.size() * sizeof(float), m_verts.data(), GL_STATIC_DRAW);
 }
@@ -2,39 +2,167 @@
 
 namespace engine
 {
-	Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture*> textures)
+	Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture*> textures, VertexFormat format, bool keepData)
 	{
-		//Set the mesh data
-		this->vertices = vertices;
-		this->indices = indices;
-		this->textures = textures;
+		this->textures = std::move(textures);
+		vertexFormat = format;
+		vertexCount = vertices.size();
+		indexCount = indices.size();
+		indexType = IndexTypeFor(vertices.size());
+
+		for (const Vertex& vertex : vertices)
+			bounds.Expand(vertex.Position);
+
+		//Convert to the GPU formats
+		std::vector<PackedVertex> packedVertices;
+		const void* vertexData = vertices.data();
+		if (format == VertexFormat::packedNormals)
+		{
+			packedVertices.reserve(vertices.size());
+			for (const Vertex& vertex : vertices)
+				packedVertices.push_back(PackedVertex{ vertex.Position, PackNormal(vertex.Normal), vertex.TexCoords });
+			vertexData = packedVertices.data();
+		}
+
+		std::vector<uint16_t> shortIndices;
+		const void* indexData = indices.data();
+		if (indexType == GL_UNSIGNED_SHORT)
+		{
+			shortIndices.assign(indices.begin(), indices.end());
+			indexData = shortIndices.data();
+		}
+
+		Upload(vertexData, indexData);
+
+		//Otherwise the data is freed when the arguments go out of scope
+		if (keepData)
+		{
+			this->vertices = std::move(vertices);
+			this->indices = std::move(indices);
+			keptData = true;
+		}
+	}
+
+	Mesh::Mesh(const void* vertices, size_t vertexCount, VertexFormat format, const void* indices, size_t indexCount, unsigned int indexType, std::vector<Texture*> textures, const AABB& bounds, bool keepData)
+	{
+		this->textures = std::move(textures);
+		this->bounds = bounds;
+		this->vertexFormat = format;
+		this->vertexCount = vertexCount;
+		this->indexCount = indexCount;
+		this->indexType = indexType;
+
+		Upload(vertices, indices);
+
+		if (!keepData)
+			return;
+
+		//Copy the data out of the given memory, unpacking it into the CPU side formats
+		this->vertices.resize(vertexCount);
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			if (format == VertexFormat::packedNormals)
+			{
+				const PackedVertex& packed = ((const PackedVertex*)vertices)[i];
+				this->vertices[i] = Vertex{ packed.Position, UnpackNormal(packed.Normal), packed.TexCoords };
+			}
+			else
+				this->vertices[i] = ((const Vertex*)vertices)[i];
+		}
+		if (indexType == GL_UNSIGNED_SHORT)
+			this->indices.assign((const uint16_t*)indices, (const uint16_t*)indices + indexCount);
+		else
+			this->indices.assign((const uint32_t*)indices, (const uint32_t*)indices + indexCount);
+		keptData = true;
+	}
+
+	Mesh::~Mesh()
+	{
+		Release();
+	}
+
+	Mesh::Mesh(Mesh&& other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	Mesh& Mesh::operator=(Mesh&& other) noexcept
+	{
+		if (this == &other)
+			return *this;
+
+		Release();
+
+		vertices = std::move(other.vertices);
+		indices = std::move(other.indices);
+		textures = std::move(other.textures);
+		textureTypes = std::move(other.textureTypes);
+		VAO = other.VAO;
+		VBO = other.VBO;
+		EBO = other.EBO;
+		vertexCount = other.vertexCount;
+		indexCount = other.indexCount;
+		indexType = other.indexType;
+		vertexFormat = other.vertexFormat;
+		bounds = other.bounds;
+		instanceAttributes = other.instanceAttributes;
+		keptData = other.keptData;
+
+		//The moved from mesh no longer owns the buffers
+		other.VAO = other.VBO = other.EBO = 0;
+		other.vertexCount = other.indexCount = 0;
+		other.keptData = false;
+		return *this;
+	}
+
+	//Delete the buffers if this mesh owns any
+	void Mesh::Release()
+	{
+		if (!VAO)
+			return;
+
+		RenderState::Get()->DeleteVertexArray(VAO);
+		RenderState::Get()->DeleteBuffer(VBO);
+		RenderState::Get()->DeleteBuffer(EBO);
+		glDeleteVertexArrays(1, &VAO);
+		glDeleteBuffers(1, &VBO);
+		glDeleteBuffers(1, &EBO);
+		VAO = VBO = EBO = 0;
+	}
+
+	void Mesh::Upload(const void* vertexData, const void* indexData)
+	{
+		size_t vertexSize = VertexSize(vertexFormat);
 
 		//OpenGL buffers
 		glGenVertexArrays(1, &VAO);
 		glGenBuffers(1, &VBO);
 		glGenBuffers(1, &EBO);
 
-		glBindVertexArray(VAO);
+		RenderState::Get()->BindVertexArray(VAO);
 
 		//Vertices to VBO
-		glBindBuffer(GL_ARRAY_BUFFER, VBO);
-		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+		RenderState::Get()->BindBuffer(GL_ARRAY_BUFFER, VBO);
+		glBufferData(GL_ARRAY_BUFFER, vertexCount * vertexSize, vertexData, GL_STATIC_DRAW);
 
 		//Draw indices to EBO
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+		RenderState::Get()->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * IndexSize(indexType), indexData, GL_STATIC_DRAW);
 
 		//Vertex positions
 		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-		//Vertex normals
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, vertexSize, (void*)0);
+		//Vertex normals, packed normals are normalized back to -1 to 1
 		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+		if (vertexFormat == VertexFormat::packedNormals)
+			glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, vertexSize, (void*)offsetof(PackedVertex, Normal));
+		else
+			glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, vertexSize, (void*)offsetof(Vertex, Normal));
 		//Vertex texture coords
 		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, vertexSize, (void*)(vertexFormat == VertexFormat::packedNormals ? offsetof(PackedVertex, TexCoords) : offsetof(Vertex, TexCoords)));
 
 		//Unbind VAO
-		glBindVertexArray(0);
+		RenderState::Get()->BindVertexArray(0);
 	}
 }
\ No newline at end of file
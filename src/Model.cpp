@@ -1,48 +1,119 @@
 #include <engine/Model.h>
+#include <engine/FileSystem.h>
+#include <assimp/DefaultIOSystem.h>
+#include <assimp/MemoryIOWrapper.h>
 
 namespace engine
 {
-	void Model::LoadModel(std::string path)
+	void Model::LoadModel(std::string path, const MeshOptimizer::Options& options, bool keepMeshData)
+	{
+		//Save the original model's directory, textures are relative to it
+		directory = path.substr(0, path.find_last_of('/'));
+
+		//Cooked models skip Assimp entirely
+		if (CookedModel::IsCooked(path))
+		{
+			LoadCooked(path, keepMeshData);
+			return;
+		}
+
+		ModelData model;
+		if (!Import(path, model, options))
+			return;
+
+		meshes.reserve(model.meshes.size());
+		for (MeshData& mesh : model.meshes)
+		{
+			meshes.push_back(Mesh(std::move(mesh.vertices), std::move(mesh.indices), LoadTextures(mesh.textures), mesh.vertexFormat, keepMeshData));
+			meshes.back().textureTypes = TextureTypes(mesh.textures);
+		}
+		bounds = model.bounds;
+	}
+
+	//Map a cooked model and upload each mesh straight from the mapped file
+	void Model::LoadCooked(const std::string& path, bool keepMeshData)
+	{
+		CookedModel cooked;
+		if (!cooked.Open(path))
+			return;
+
+		meshes.reserve(cooked.MeshCount());
+		for (size_t i = 0; i < cooked.MeshCount(); i++)
+		{
+			CookedModel::MeshView mesh = cooked.GetMesh(i);
+			meshes.push_back(Mesh(mesh.vertices, mesh.vertexCount, mesh.vertexFormat, mesh.indices, mesh.indexCount, mesh.indexType, LoadTextures(mesh.textures), mesh.bounds, keepMeshData));
+			meshes.back().textureTypes = TextureTypes(mesh.textures);
+		}
+		bounds = cooked.Bounds();
+	}
+
+	//Lets Assimp read models and their material files from mounted asset packs, anything not in a pack is read from disk
+	class PackIOSystem : public Assimp::DefaultIOSystem
+	{
+	public:
+		bool Exists(const char* path) const override
+		{
+			return (bool)FileSystem::Get()->Find(path) || DefaultIOSystem::Exists(path);
+		}
+
+		Assimp::IOStream* Open(const char* path, const char* mode = "rb") override
+		{
+			FileView file = FileSystem::Get()->Find(path);
+			if (file)
+				return new Assimp::MemoryIOStream(file.data, file.size);
+			return DefaultIOSystem::Open(path, mode);
+		}
+	};
+
+	bool Model::Import(const std::string& path, ModelData& model, const MeshOptimizer::Options& options, MeshOptimizer::Report* report)
 	{
 		//Load model with Assimp, convert all primitives to triangles and flip texture UVs for OpenGL
 		Assimp::Importer import;
+		import.SetIOHandler(new PackIOSystem());
 		const aiScene* scene = import.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);
 		
 		//Make sure the model scene is not null and it imported properly
 		if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
 		{
 			std::cout << "ERROR::ASSIMP::" << import.GetErrorString() << std::endl;
-			return;
+			return false;
 		}
 
-		//Save the original model's directory
-		directory = path.substr(0, path.find_last_of('/'));
+		ProcessNode(scene->mRootNode, scene, model);
 
-		ProcessNode(scene->mRootNode, scene);
+		//Weld and reorder the vertices, Assimp only gives them as they are in the file
+		for (MeshData& mesh : model.meshes)
+			MeshOptimizer::Optimize(mesh, options, report);
+
+		//The model's bounds contain every mesh, used for culling
+		for (const MeshData& mesh : model.meshes)
+			model.bounds.Expand(mesh.bounds);
+		return true;
 	}
 	
 	//Call ProcessNode recursively on every child node of root node
-	void Model::ProcessNode(aiNode* node, const aiScene* scene)
+	void Model::ProcessNode(aiNode* node, const aiScene* scene, ModelData& model)
 	{
 		//Process all the node's meshes (if any)
 		for (unsigned int i = 0; i < node->mNumMeshes; i++)
 		{
 			aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-			meshes.push_back(ProcessMesh(mesh, scene));
+			model.meshes.push_back(ProcessMesh(mesh, scene));
 		}
 		//Then do the same for each of its children
 		for (unsigned int i = 0; i < node->mNumChildren; i++)
 		{
-			ProcessNode(node->mChildren[i], scene);
+			ProcessNode(node->mChildren[i], scene, model);
 		}
 	}
 
 	//Call ProcessMesh on every mesh originating from node
-	Mesh Model::ProcessMesh(aiMesh* mesh, const aiScene* scene)
+	MeshData Model::ProcessMesh(aiMesh* mesh, const aiScene* scene)
 	{
-		std::vector<Mesh::Vertex> vertices;
-		std::vector<unsigned int> indices;
-		std::vector<Texture*> textures;
+		MeshData data;
+		std::vector<Mesh::Vertex>& vertices = data.vertices;
+		std::vector<unsigned int>& indices = data.indices;
+		vertices.reserve(mesh->mNumVertices);
 
 		//For each vertex in the mesh
 		for (unsigned int i = 0; i < mesh->mNumVertices; i++)
@@ -75,6 +146,7 @@ namespace engine
 
 			//Add the processed vertex to the list
 			vertices.push_back(vertex);
+			data.bounds.Expand(vertex.Position);
 		}
 
 		//For each face in the mesh
@@ -92,49 +164,49 @@ namespace engine
 			//Get the scene material vector
 			aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
 
-			std::vector<Texture*> diffuseMaps = LoadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
-			textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
-
-			std::vector<Texture*> specularMaps = LoadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
-			textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+			GetMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse", data.textures);
+			GetMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular", data.textures);
 		}
 
-		return Mesh(vertices, indices, textures);
+		return data;
 	}
 
-	//Loads every texture of specific type in a material
-	std::vector<Texture*> Model::LoadMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName)
+	//Gets the location of every texture of specific type in a material
+	void Model::GetMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName, std::vector<MaterialTexture>& textures)
 	{
-		std::vector<Texture*> textures;
 		//For each material texture
 		for (unsigned int i = 0; i < mat->GetTextureCount(type); i++)
 		{
 			//Get the location of the texture
 			aiString textureLoc;
 			mat->GetTexture(type, i, &textureLoc);
+			textures.push_back(MaterialTexture{ typeName, textureLoc.C_Str() });
+		}
+	}
 
-			//Check if the texture has already been loaded
-			bool skip = false; 
-			for (unsigned int j = 0; j < textures_loaded.size(); j++)
-			{
-				if (std::strcmp(textures_loaded[j]->path.data(), textureLoc.C_Str()) == 0)
-				{
-					textures.push_back(textures_loaded[j]);
-					skip = true;
-					break;
-				}
-			}
+	//Loads the textures of a mesh's material, textures shared with other meshes or models are only loaded once
+	std::vector<Texture*> Model::LoadTextures(const std::vector<MaterialTexture>& materialTextures)
+	{
+		std::vector<Texture*> textures;
+		for (const MaterialTexture& materialTexture : materialTextures)
+		{
+			//Load the texture from location relative to model. It is shared, so its material slot is kept by the mesh instead
+			AssetHandle<Texture> texture = AssetManager::Get()->Load<Texture>(directory + "/" + materialTexture.path, GL_LINEAR, false);
+			textures.push_back(texture);
 
-			//If the texture has not been loaded, load it
-			if (!skip)
-			{
-				//Load the texture from location relative to model
-				Texture* texture = new Texture((directory + "/" + textureLoc.C_Str()).c_str(), GL_LINEAR, false);
-				texture->type = typeName;
-				texture->path = textureLoc.C_Str();
-				textures.push_back(texture);
-			}
+			//Keep one reference per texture
+			if (std::find(textures_loaded.begin(), textures_loaded.end(), texture.Get()) == textures_loaded.end())
+				textures_loaded.push_back(texture);
 		}
 		return textures;
 	}
+
+	//The material slot of each texture, in the same order as LoadTextures returns them
+	std::vector<std::string> Model::TextureTypes(const std::vector<MaterialTexture>& materialTextures)
+	{
+		std::vector<std::string> types;
+		for (const MaterialTexture& materialTexture : materialTextures)
+			types.push_back(materialTexture.type);
+		return types;
+	}
 }
\ No newline at end of file
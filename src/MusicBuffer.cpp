@@ -129,7 +129,8 @@ MusicBuffer::MusicBuffer(const char* filename)
 
 	std::size_t frame_size;
 
-	p_SndFile = sf_open(filename, SFM_READ, &p_Sfinfo);
+	p_Sfinfo = {};
+	p_SndFile = OpenSoundFile(filename, &p_Sfinfo, p_Memory);
 	if (!p_SndFile)
 	{
 		throw("could not open music file");
@@ -0,0 +1,36 @@
+//Physics.h expects the headers Application.h includes before it
+#include <engine/Sprite.h>
+#include <engine/Physics.h>
+#include <engine/GL/DebugDraw.h>
+
+namespace engine
+{
+	void PhysicsSystem::Visualize()
+	{
+		DebugDraw* debugDraw = DebugDraw::Get();
+		for (auto const& entity : entities)
+		{
+			BoxCollider& collider = ecs.getComponent<BoxCollider>(entity);
+			std::array<float, 4> bounds = GetBounds(entity);
+
+			//Top, right, bottom, left
+			Vector2 corners[4] = { Vector2(bounds[3], bounds[0]), Vector2(bounds[1], bounds[0]), Vector2(bounds[1], bounds[2]), Vector2(bounds[3], bounds[2]) };
+			for (int side = 0; side < 4; side++)
+			{
+				Vector3 color = collider.sidesCollided[side] ? Vector3(255, 0, 0) : collider.isTrigger ? Vector3(255, 220, 0) : Vector3(0, 255, 0);
+				debugDraw->Line(corners[side], corners[(side + 1) % 4], color);
+			}
+
+			for (const Collision& collision : collider.collisions)
+			{
+				if (collision.type != Collision::Type::entity && collision.type != Collision::Type::entityTrigger)
+					continue;
+
+				std::array<float, 4> aBounds = GetBounds(collision.a);
+				std::array<float, 4> bBounds = GetBounds(collision.b);
+				Vector2 contact((max(aBounds[3], bBounds[3]) + min(aBounds[1], bBounds[1])) / 2, (max(aBounds[2], bBounds[2]) + min(aBounds[0], bBounds[0])) / 2);
+				debugDraw->Cross(contact, 6, Vector3(255, 0, 0));
+			}
+		}
+	}
+}
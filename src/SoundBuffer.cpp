@@ -1,8 +1,9 @@
 #include <engine/AL/SoundBuffer.h>
-#include <sndfile.h>
+#include <engine/AL/SoundFile.h>
 #include <inttypes.h>
 #include <AL/alext.h>
 #include <climits>
+#include <cstdlib>
 
 SoundBuffer* SoundBuffer::getFile()
 {
@@ -15,13 +16,14 @@ ALuint SoundBuffer::addSoundEffect(const char* filename)
 	ALenum err, format;
 	ALuint buffer;
 	SNDFILE* sndfile;
-	SF_INFO sfinfo;
+	SF_INFO sfinfo = {};
+	MemorySoundFile memory;
 	short* membuf;
 	sf_count_t num_frames;
 	ALsizei num_bytes;
 
 	//Open the audiofile and check if usable
-	sndfile = sf_open(filename, SFM_READ, &sfinfo);
+	sndfile = OpenSoundFile(filename, &sfinfo, memory);
 	if (!sndfile)
 	{
 		fprintf(stderr, "could not open audio in %s: %s \n", filename, sf_strerror(sndfile));
@@ -1,14 +1,18 @@
 #include "engine/TextRender.h"
+#include <engine/GL/UniformBuffer.h>
+#include <engine/FileSystem.h>
+#include <engine/TextureAtlas.h>
 
 using namespace engine;
 
 TextRender::TextRender()
 {
-	glEnable(GL_CULL_FACE);
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	RenderState::Get()->Enable(GL_CULL_FACE);
+	RenderState::Get()->Enable(GL_BLEND);
+	RenderState::Get()->BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 	m_shader = new Shader("textVertexShader.glsl", "textFragmentShader.glsl", true);
+	glyphAtlas = new TextureAtlas(1024, 1024, 1, GL_LINEAR);
 
 	try
 	{
@@ -26,6 +30,11 @@ TextRender::TextRender()
 
 TextRender::~TextRender()
 {
+	delete glyphAtlas;
+	RenderState::Get()->DeleteBuffer(VBO);
+	RenderState::Get()->DeleteVertexArray(VAO);
+	glDeleteBuffers(1, &VBO);
+	glDeleteVertexArrays(1, &VAO);
 }
 
 
@@ -42,7 +51,12 @@ vector<FT_Face> TextRender::SetUpTTF(FT_Face face, const char* filepathname, FT_
 
 	try
 	{
-		if (FT_New_Face(ft, truefont.filepathname, truefont.face_index, &face))
+		//Fonts in a mounted asset pack are read straight from it, the pack stays mapped while the face is used
+		FileView file = FileSystem::Get()->Find(truefont.filepathname);
+		FT_Error error = file
+			? FT_New_Memory_Face(ft, file.data, (FT_Long)file.size, truefont.face_index, &face)
+			: FT_New_Face(ft, truefont.filepathname, truefont.face_index, &face);
+		if (error)
 		{
 			throw runtime_error("Failed to load font from: " + string(truefont.filepathname));
 		}
@@ -67,62 +81,59 @@ void TextRender::TexConfig()
 {
 	glGenVertexArrays(1, &VAO);
 	glGenBuffers(1, &VBO);
-	glBindVertexArray(VAO);
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	RenderState::Get()->BindVertexArray(VAO);
+	RenderState::Get()->BindBuffer(GL_ARRAY_BUFFER, VBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
+	RenderState::Get()->BindBuffer(GL_ARRAY_BUFFER, 0);
+	RenderState::Get()->BindVertexArray(0);
 }
 
 
+//Decode the UTF-8 code point starting at text[i] and move i past it, invalid or cut off sequences decode to U+FFFD
+static char32_t DecodeUTF8(const string& text, size_t& i)
+{
+	unsigned char lead = text[i++];
+	if (lead < 0x80)
+		return lead;
+
+	int length;
+	char32_t codePoint;
+	if ((lead & 0xE0) == 0xC0)
+	{
+		length = 1;
+		codePoint = lead & 0x1F;
+	}
+	else if ((lead & 0xF0) == 0xE0)
+	{
+		length = 2;
+		codePoint = lead & 0x0F;
+	}
+	else if ((lead & 0xF8) == 0xF0)
+	{
+		length = 3;
+		codePoint = lead & 0x07;
+	}
+	else
+		return 0xFFFD;
+
+	for (int k = 0; k < length; k++)
+	{
+		if (i >= text.size() || (text[i] & 0xC0) != 0x80)
+			return 0xFFFD;
+		codePoint = (codePoint << 6) | (text[i] & 0x3F);
+		i++;
+	}
+	return codePoint;
+}
+
 void TextRender::LoadText(vector<FT_Face> Faces)
 {
 	for (int f = 0; f < Faces.size(); ++f)
 	{
 		FT_Face face = Faces[f];
-
-		for (unsigned char c = 0; c < 128; ++c)
-		{
-			if (FT_Load_Char(face, c, FT_LOAD_RENDER))
-			{
-				cout << "ERROR::FREETYTPE: Failed to load Glyph" << endl;
-				continue;
-			}
-
-			glGenTextures(1, &texture);
-			glBindTexture(GL_TEXTURE_2D, texture);
-			glTexImage2D(
-				GL_TEXTURE_2D,
-				0,
-				GL_RED,
-				face->glyph->bitmap.width,
-				face->glyph->bitmap.rows,
-				0,
-				GL_RED,
-				GL_UNSIGNED_BYTE,
-				face->glyph->bitmap.buffer
-			);
-
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-			Character character = {
-					texture,
-					glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-					glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-					static_cast<unsigned int>(face->glyph->advance.x)
-			};
-
-			Characters.insert(pair<char, Character>(c, character));
-
-		}
-		StyleLinker.insert(pair<string, map<GLchar, Character>>(face->family_name, Characters));
-
-		glBindTexture(GL_TEXTURE_2D, 0);
+		StyleLinker.insert(pair<string, FontStyle>(face->family_name, FontStyle{ face, {} }));
 
 		//FT_Done_Face(face);
 	}
@@ -131,62 +142,278 @@ void TextRender::LoadText(vector<FT_Face> Faces)
 	TexConfig();
 }
 
+const Character* TextRender::FindGlyph(FontStyle& style, char32_t codePoint)
+{
+	auto found = style.characters.find(codePoint);
+	if (found != style.characters.end())
+		return &found->second;
 
-void TextRender::RenderText(string styleName, Camera* cam, string text, float x, float y, float scale, glm::vec3 colour)
+	FT_Face face = style.face;
+	if (FT_Load_Char(face, codePoint, FT_LOAD_RENDER))
+	{
+		cout << "ERROR::FREETYTPE: Failed to load Glyph" << endl;
+		return nullptr;
+	}
+
+	const FT_Bitmap& bitmap = face->glyph->bitmap;
+	Character character = {
+			nullptr,
+			glm::vec4(0),
+			glm::ivec2(bitmap.width, bitmap.rows),
+			glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
+			static_cast<unsigned int>(face->glyph->advance.x),
+			face->glyph->glyph_index
+	};
+
+	if (bitmap.width > 0 && bitmap.rows > 0)
+	{
+		//The atlas wants RGBA from the bottom row up, FreeType gives one coverage byte per pixel from the top row down
+		//Coverage goes in every channel so the text shader can keep reading it from red
+		glyphPixels.resize(bitmap.width * bitmap.rows * 4);
+		for (unsigned int row = 0; row < bitmap.rows; row++)
+		{
+			const unsigned char* source = bitmap.buffer + row * bitmap.pitch;
+			unsigned char* destination = &glyphPixels[(bitmap.rows - 1 - row) * bitmap.width * 4];
+			for (unsigned int x = 0; x < bitmap.width; x++)
+				memset(destination + x * 4, source[x], 4);
+		}
+
+		//Use room left on the pages first, then start a new page while under the limit, then clear the coldest page to make room
+		AtlasRegion region;
+		bool added = glyphAtlas->TryAddPixels(glyphPixels.data(), bitmap.width, bitmap.rows, region);
+		if (!added && glyphAtlas->PageCount() >= maxGlyphPages && EvictGlyphPage())
+			added = glyphAtlas->TryAddPixels(glyphPixels.data(), bitmap.width, bitmap.rows, region);
+		if (!added)
+			region = glyphAtlas->AddPixels(glyphPixels.data(), bitmap.width, bitmap.rows);
+
+		character.texture = region.texture;
+		character.uvRect = region.uvRect;
+		MarkPageUsed(region.texture);
+	}
+
+	return &style.characters.emplace(codePoint, character).first->second;
+}
+
+bool TextRender::EvictGlyphPage()
 {
-	m_shader->use();
-	projection = cam->GetProjectionMatrix();
-	viewMatrix = cam->GetViewMatrix();
-	glUniformMatrix4fv(glGetUniformLocation(m_shader->ID, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-	glUniformMatrix4fv(glGetUniformLocation(m_shader->ID, "viewMatrix"), 1, GL_FALSE, glm::value_ptr(viewMatrix));
-	glUniform3f(glGetUniformLocation(m_shader->ID, "textColour"), colour.x, colour.y, colour.z);
-	glActiveTexture(GL_TEXTURE0);
-	glBindVertexArray(VAO);
+	//Pages used by the string being laid out have the current stamp and are never picked
+	Texture* coldest = nullptr;
+	uint64_t coldestStamp = useStamp;
+	for (const auto& [page, stamp] : pageLastUsed)
+	{
+		if (stamp < coldestStamp)
+		{
+			coldest = page;
+			coldestStamp = stamp;
+		}
+	}
+	if (!coldest)
+		return false;
 
+	//Forget every glyph on the page, they are rasterized again the next time they are drawn
+	for (auto& [name, style] : StyleLinker)
+		erase_if(style.characters, [coldest](const auto& glyph) { return glyph.second.texture == coldest; });
+
+	glyphAtlas->ClearPage(coldest);
+	pageLastUsed.erase(coldest);
+	glyphGeneration++;
+	return true;
+}
+
+float TextRender::LayoutText(const string& styleName, const string& text, float x, float y, float scale, vector<float>& vertices, vector<pair<Texture*, unsigned int>>& pageDraws)
+{
 	auto it = StyleLinker.find(styleName);
+	if (it == StyleLinker.end())
+	{
+		cout << "error" << endl;
+		return x;
+	}
+	FontStyle& style = it->second;
+	const bool kerning = FT_HAS_KERNING(style.face);
 
-	if (it != StyleLinker.end())
+	FT_UInt previous = 0;
+	for (size_t i = 0; i < text.size();)
 	{
-		map<GLchar, Character> currentCharacters = it->second;
+		const Character* glyph = FindGlyph(style, DecodeUTF8(text, i));
+		if (!glyph)
+			continue;
+		const Character& ch = *glyph;
 
-		string::const_iterator c;
-		for (c = text.begin(); c != text.end(); ++c)
+		//Pull pairs like "AV" closer together the way the font wants
+		if (kerning && previous && ch.glyphIndex)
 		{
-			Character ch = currentCharacters[*c];
+			FT_Vector delta;
+			FT_Get_Kerning(style.face, previous, ch.glyphIndex, FT_KERNING_DEFAULT, &delta);
+			x += (delta.x >> 6) * scale;
+		}
+		previous = ch.glyphIndex;
 
+		if (ch.texture)
+		{
 			float xpos = x + ch.Bearing.x * scale;
 			float ypos = y - (ch.Size.y - ch.Bearing.y) * scale;
 
 			float w = ch.Size.x * scale;
 			float h = ch.Size.y * scale;
 
-			float vertices[6][4] = {
-				{xpos, ypos + h, 0.0f, 0.0f },
-				{xpos, ypos, 0.0f, 1.0f },
-				{xpos + w, ypos, 1.0f, 1.0f },
+			const glm::vec4& uv = ch.uvRect;
+			float quad[6][4] = {
+				{xpos, ypos + h, uv.x, uv.w },
+				{xpos, ypos, uv.x, uv.y },
+				{xpos + w, ypos, uv.z, uv.y },
 
-				{xpos, ypos + h, 0.0f, 0.0f },
-				{xpos + w, ypos, 1.0f, 1.0f },
-				{xpos + w, ypos + h, 1.0f, 0.0f}
+				{xpos, ypos + h, uv.x, uv.w },
+				{xpos + w, ypos, uv.z, uv.y },
+				{xpos + w, ypos + h, uv.z, uv.w}
 			};
+			vertices.insert(vertices.end(), &quad[0][0], &quad[0][0] + 24);
 
-			printf("RenderText: %s, textureId: %d\n", text.c_str(), ch.TextureID);
-			glBindTexture(GL_TEXTURE_2D, ch.TextureID);
-			glBindBuffer(GL_ARRAY_BUFFER, VBO);
-			glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-			glBindBuffer(GL_ARRAY_BUFFER, 0);
-			glDrawArrays(GL_TRIANGLES, 0, 6);
-			x += (ch.Advance >> 6) * scale;
-
+			if (pageDraws.empty() || pageDraws.back().first != ch.texture)
+				pageDraws.push_back({ ch.texture, 0 });
+			pageDraws.back().second += 6;
+			MarkPageUsed(ch.texture);
 		}
-
-		currentCharacters.clear();
+		x += (ch.Advance >> 6) * scale;
 	}
-	else
+	return x;
+}
+
+void TextRender::UseShader(Camera* cam, glm::vec3 colour, const glm::mat4& model)
+{
+	m_shader->use();
+	CameraUniformBuffer* cameraBuffer = CameraUniformBuffer::Get();
+	cameraBuffer->Update(cam);
+	cameraBuffer->Use(m_shader);
+	m_shader->SetVec3("textColour", colour);
+	m_shader->SetMat4("model", model);
+}
+
+void TextRender::RenderText(string styleName, Camera* cam, string text, float x, float y, float scale, glm::vec3 colour)
+{
+	//Build the quads of the whole string, starting a new draw whenever the atlas page changes
+	vertices.clear();
+	pageDraws.clear();
+	StartLayout();
+	LayoutText(styleName, text, x, y, scale, vertices, pageDraws);
+	DrawVertices(cam, colour);
+}
+
+void TextRender::RenderTexts(string styleName, Camera* cam, const vector<pair<glm::vec2, string>>& texts, float scale, glm::vec3 colour)
+{
+	//Strings on the same page as the one before them keep adding to its draw
+	vertices.clear();
+	pageDraws.clear();
+	StartLayout();
+	for (const auto& [position, text] : texts)
+		LayoutText(styleName, text, position.x, position.y, scale, vertices, pageDraws);
+	DrawVertices(cam, colour);
+}
+
+void TextRender::DrawVertices(Camera* cam, glm::vec3 colour)
+{
+	if (vertices.empty())
+		return;
+
+	//The quads are already where they go, layouts may have left another transform set
+	UseShader(cam, colour, glm::mat4(1.0f));
+
+	//Orphan the buffer so the driver doesn't wait for the previous string's draw
+	RenderState::Get()->BindVertexArray(VAO);
+	RenderState::Get()->BindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STREAM_DRAW);
+
+	unsigned int first = 0;
+	for (const auto& [page, count] : pageDraws)
 	{
-		cout << "error" << endl;
+		page->Use(0);
+		glDrawArrays(GL_TRIANGLES, first, count);
+		first += count;
 	}
-	glBindVertexArray(0);
-	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+
+TextLayout::TextLayout(TextRender* renderer, string styleName, string text, float scale)
+	: renderer(renderer), styleName(styleName), text(text), scale(scale)
+{
+	glGenVertexArrays(1, &VAO);
+	glGenBuffers(1, &VBO);
+	RenderState::Get()->BindVertexArray(VAO);
+	RenderState::Get()->BindBuffer(GL_ARRAY_BUFFER, VBO);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
+	RenderState::Get()->BindVertexArray(0);
+}
+
+TextLayout::~TextLayout()
+{
+	RenderState::Get()->DeleteBuffer(VBO);
+	RenderState::Get()->DeleteVertexArray(VAO);
+	glDeleteBuffers(1, &VBO);
+	glDeleteVertexArrays(1, &VAO);
+}
+
+void TextLayout::SetText(const string& text)
+{
+	if (text == this->text)
+		return;
+	this->text = text;
+	dirty = true;
+}
+
+void TextLayout::SetScale(float scale)
+{
+	if (scale == this->scale)
+		return;
+	this->scale = scale;
+	dirty = true;
+}
+
+float TextLayout::Width()
+{
+	Build();
+	return width;
+}
+
+void TextLayout::Build()
+{
+	if (!dirty && generation == renderer->GlyphGeneration())
+		return;
+	dirty = false;
+
+	//Laid out from the origin so the transform places it, the renderer's scratch buffer is reused for the quads
+	vector<float>& vertices = renderer->vertices;
+	vertices.clear();
+	pageDraws.clear();
+	renderer->StartLayout();
+	width = renderer->LayoutText(styleName, text, 0, 0, scale, vertices, pageDraws);
+	generation = renderer->GlyphGeneration();
+
+	RenderState::Get()->BindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+}
+
+void TextLayout::Draw(Camera* cam, float x, float y, glm::vec3 colour)
+{
+	Draw(cam, glm::translate(glm::mat4(1.0f), glm::vec3(x, y, 0)), colour);
+}
 
-}
\ No newline at end of file
+void TextLayout::Draw(Camera* cam, const glm::mat4& transform, glm::vec3 colour)
+{
+	Build();
+	if (pageDraws.empty())
+		return;
+
+	renderer->UseShader(cam, colour, transform);
+	RenderState::Get()->BindVertexArray(VAO);
+
+	//Drawing the layout keeps its glyph pages from being evicted
+	renderer->StartLayout();
+	unsigned int first = 0;
+	for (const auto& [page, count] : pageDraws)
+	{
+		renderer->MarkPageUsed(page);
+		page->Use(0);
+		glDrawArrays(GL_TRIANGLES, first, count);
+		first += count;
+	}
+}
@@ -30,6 +30,8 @@ source distribution.
 #include <tmxlite/Map.hpp>
 #include <engine/GL/Shader.h>
 #include <engine/GL/Texture.h>
+#include <engine/FileSystem.h>
+#include <engine/GL/UniformBuffer.h>
 #include <engine/MapLayer.h>
 #include <cassert>
 #include <array>
@@ -37,6 +39,8 @@ source distribution.
 #include <cmath>
 #include <tmxlite/TileLayer.hpp>
 #include <algorithm>
+#include <filesystem>
+#include <iostream>
 
 Tilemap::Tilemap(engine::Camera* cam)
 {
@@ -48,10 +52,15 @@ Tilemap::Tilemap(engine::Camera* cam)
 
 Tilemap::~Tilemap()
 {
+	stopStreamingThread();
 }
 
 void Tilemap::draw(float layer)
 {
+	//zLayers always has the lowest layer drawn first each frame
+	if (streaming && layer == *zLayers.begin())
+		updateStreaming();
+
 	if (mapLayers.count(layer) == 0)
 		return;
 
@@ -59,29 +68,39 @@ void Tilemap::draw(float layer)
 
 	glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
 
-	unsigned int modelLoc = glGetUniformLocation(m_shader->ID, "u_modelMatrix");
+	unsigned int modelLoc = m_shader->GetUniformLocation("u_modelMatrix");
 
-	unsigned int viewLoc = glGetUniformLocation(m_shader->ID, "u_viewMatrix");
-	glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(camera->GetViewMatrix()));
+	//Give the shader the view and projection matrices
+	engine::CameraUniformBuffer* cameraBuffer = engine::CameraUniformBuffer::Get();
+	cameraBuffer->Update(camera);
+	cameraBuffer->Use(m_shader);
 
-	//Give the shader the projection matrix
-	unsigned int projLoc = glGetUniformLocation(m_shader->ID, "u_projectionMatrix");
-	glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(camera->GetProjectionMatrix()));
+	unsigned int u_tilesetCount = m_shader->GetUniformLocation("u_tilesetCount");
 
-	unsigned int u_tilesetCount = glGetUniformLocation(m_shader->ID, "u_tilesetCount");
+	unsigned int u_tileSize = m_shader->GetUniformLocation("u_tileSize");
 
-	unsigned int u_tileSize = glGetUniformLocation(m_shader->ID, "u_tileSize");
+	//Layers only draw their chunks inside the camera's view
+	engine::Frustum frustum = camera->GetFrustum();
 
 	for (int i = 0; i < mapLayers[layer].size(); i++)
 	{
-		mapLayers[layer][i]->draw(model, modelLoc, u_tilesetCount, u_tileSize);
+		mapLayers[layer][i]->draw(model, modelLoc, u_tilesetCount, u_tileSize, frustum);
 	}
 }
 
 void Tilemap::loadMap(const std::string ownMap)
 {
+	//A streaming map can't be mixed with a loaded one
+	if (streaming)
+		clearMap();
+
 	tmx::Map map;
-	map.load(ownMap);
+	//Parse the map from a mounted asset pack if it has it, tileset images are then found in the pack too
+	engine::FileView file = engine::FileSystem::Get()->Find(ownMap);
+	if (file)
+		map.loadFromString(std::string((const char*)file.data, file.size), ownMap);
+	else
+		map.load(ownMap);
 
 	//create shared resources, shader and tileset textures
 	initGLStuff(map);
@@ -141,15 +160,164 @@ void Tilemap::loadMap(const std::string ownMap)
 	}
 }
 
+void Tilemap::loadStreamingMap(const std::string& manifestPath)
+{
+	//Loading a map replaces the one loaded before, the streaming thread reads the manifest so it has to stop first
+	clearMap();
+
+	if (!manifest.Read(manifestPath))
+	{
+		std::cout << "Failed to read map manifest " << manifestPath << std::endl;
+		return;
+	}
+	this->manifestPath = manifestPath;
+
+	initShader();
+
+	//Tileset images are next to the manifest, or wherever the tool found them relative to it
+	const std::filesystem::path directory = std::filesystem::path(manifestPath).parent_path();
+	for (const auto& ts : manifest.tilesets)
+	{
+		allTextures.push_back(loadTexture((directory / ts.imagePath).lexically_normal().generic_string()));
+		tilesetRanges.push_back(MapLayer::TilesetRange{ ts.firstGID, ts.tileCount, ts.columns });
+	}
+
+	bounds = tmx::FloatRect(manifest.left, manifest.top, (float)manifest.width * manifest.tileWidth, (float)manifest.height * manifest.tileHeight);
+	tileSize = tmx::Vector2u(manifest.tileWidth, manifest.tileHeight);
+	zLayers.insert(0);
+
+	//Every layer starts empty and gets its part of each chunk as it is loaded
+	for (const auto& layerInfo : manifest.layers)
+	{
+		if (layerInfo.collider)
+			continue;
+
+		std::shared_ptr<MapLayer> layer = std::make_shared<MapLayer>(allTextures);
+		if (!manifest.tilesets.empty())
+			layer->tileSize = glm::vec2(manifest.tilesets[0].tileWidth, manifest.tilesets[0].tileHeight);
+		layer->zLayer = layerInfo.z;
+		zLayers.insert(layerInfo.z);
+		mapLayers[layer->zLayer].push_back(layer);
+		streamLayers.push_back(layer);
+	}
+
+	streaming = true;
+	streamingThread = std::thread(&Tilemap::streamChunks, this);
+}
+
+void Tilemap::updateStreaming()
+{
+	if (!streaming)
+		return;
+
+	//Install what the streaming thread finished, unless it was unloaded while loading
+	LoadedChunk result;
+	for (unsigned int installed = 0; installed < chunksPerFrame && chunkResults.TryPop(result);)
+	{
+		if (pendingChunks.erase(result.key) == 0)
+			continue;
+		//A chunk that failed to load counts as loaded but empty, so it isn't read again every frame
+		if (!result.loaded)
+		{
+			loadedChunks.insert(result.key);
+			continue;
+		}
+		installChunk(result);
+		installed++;
+	}
+
+	//The view in the map's own coordinates, which have y pointing down
+	//Layers are drawn flipped on y only, without position, so the view is converted the same way
+	const engine::AABB view = camera->GetFrustum().bounds;
+	const float viewLeft = view.min.x - bounds.left;
+	const float viewRight = view.max.x - bounds.left;
+	const float viewTop = -view.max.y - bounds.top;
+	const float viewBottom = -view.min.y - bounds.top;
+	const glm::vec2 viewCenter((viewLeft + viewRight) / 2, (viewTop + viewBottom) / 2);
+
+	const float chunkWidth = (float)manifest.chunkSize * manifest.tileWidth;
+	const float chunkHeight = (float)manifest.chunkSize * manifest.tileHeight;
+	const int lastX = (int)manifest.ChunksWide() - 1;
+	const int lastY = (int)manifest.ChunksHigh() - 1;
+
+	//Is the chunk at x, y within distance of the view
+	auto inRange = [&](int x, int y, float distance)
+	{
+		return x * chunkWidth < viewRight + distance && (x + 1) * chunkWidth > viewLeft - distance
+			&& y * chunkHeight < viewBottom + distance && (y + 1) * chunkHeight > viewTop - distance;
+	};
+
+	//Unload chunks and drop requests gone out of range
+	const float unloadDistance = streamDistance + unloadMargin;
+	std::vector<std::uint64_t> outOfRange;
+	for (auto key : loadedChunks)
+		if (!inRange((int)(std::uint32_t)(key >> 32), (int)(std::uint32_t)key, unloadDistance))
+			outOfRange.push_back(key);
+	for (auto key : outOfRange)
+		unloadChunk(key);
+	for (auto it = pendingChunks.begin(); it != pendingChunks.end();)
+	{
+		if (!inRange((int)(std::uint32_t)(*it >> 32), (int)(std::uint32_t)*it, unloadDistance))
+			it = pendingChunks.erase(it);
+		else
+			++it;
+	}
+
+	//Request the chunks in range that aren't loaded, nearest to the view first
+	const int startX = std::max(0, (int)std::floor((viewLeft - streamDistance) / chunkWidth));
+	const int endX = std::min(lastX, (int)std::floor((viewRight + streamDistance) / chunkWidth));
+	const int startY = std::max(0, (int)std::floor((viewTop - streamDistance) / chunkHeight));
+	const int endY = std::min(lastY, (int)std::floor((viewBottom + streamDistance) / chunkHeight));
+
+	std::vector<ChunkRequest> wanted;
+	for (int y = startY; y <= endY; ++y)
+	{
+		for (int x = startX; x <= endX; ++x)
+		{
+			const auto key = chunkKey(x, y);
+			if (manifest.HasChunk(x, y) && loadedChunks.count(key) == 0 && pendingChunks.count(key) == 0)
+				wanted.push_back(ChunkRequest{ key, x, y });
+		}
+	}
+	auto distance = [&](const ChunkRequest& request)
+	{
+		return glm::length(glm::vec2((request.x + 0.5f) * chunkWidth, (request.y + 0.5f) * chunkHeight) - viewCenter);
+	};
+	std::sort(wanted.begin(), wanted.end(), [&](const ChunkRequest& a, const ChunkRequest& b) { return distance(a) < distance(b); });
+
+	for (auto& request : wanted)
+	{
+		const auto key = request.key;
+		//The rest are requested again next frame
+		if (!chunkRequests.TryPush(std::move(request)))
+			break;
+		pendingChunks.insert(key);
+		wakeStreaming.release();
+	}
+}
+
 //Returns the collision layers tile ID at x and y
 unsigned int Tilemap::checkCollision(float x, float y)
 {
-	if (collisionLayer.empty())
-		return 0;
-
 	int xIndex = floor((x + position.x) / tileSize.x);
 	int yIndex = floor((-y + position.y) / tileSize.y);
 
+	//Only the tiles of loaded chunks collide
+	if (streaming)
+	{
+		if (xIndex < 0 || yIndex < 0 || xIndex >= (int)manifest.width || yIndex >= (int)manifest.height)
+			return 0;
+		const int chunkSize = (int)manifest.chunkSize;
+		auto chunk = collisionChunks.find(chunkKey(xIndex / chunkSize, yIndex / chunkSize));
+		if (chunk == collisionChunks.end())
+			return 0;
+
+		return chunk->second.tiles[(std::size_t)(yIndex % chunkSize) * chunk->second.width + (xIndex % chunkSize)];
+	}
+
+	if (collisionLayer.empty())
+		return 0;
+
 	//Check out of bounds
 	if (xIndex >= collisionLayer.size() || yIndex >= collisionLayer[0].size() || xIndex < 0 || yIndex < 0)
 		return 0;
@@ -157,15 +325,169 @@ unsigned int Tilemap::checkCollision(float x, float y)
 	return collisionLayer[xIndex][yIndex];
 }
 
-void Tilemap::initGLStuff(const tmx::Map& map)
+std::size_t Tilemap::chunkCount() const
+{
+	std::size_t count = 0;
+	for (const auto& [z, layers] : mapLayers)
+		for (const auto& layer : layers)
+			count += layer->chunkCount();
+	return count;
+}
+
+std::size_t Tilemap::visibleChunkCount() const
+{
+	std::size_t count = 0;
+	for (const auto& [z, layers] : mapLayers)
+		for (const auto& layer : layers)
+			count += layer->visibleChunks;
+	return count;
+}
+
+std::size_t Tilemap::loadedChunkCount() const
+{
+	return loadedChunks.size();
+}
+
+//private
+std::uint64_t Tilemap::chunkKey(int x, int y)
+{
+	return ((std::uint64_t)(std::uint32_t)x << 32) | (std::uint32_t)y;
+}
+
+void Tilemap::stopStreamingThread()
+{
+	if (!streamingThread.joinable())
+		return;
+
+	stopStreaming = true;
+	wakeStreaming.release();
+	streamingThread.join();
+	stopStreaming = false;
+
+	//Throw away whatever was still queued, along with the wake ups for it
+	ChunkRequest request;
+	while (chunkRequests.TryPop(request));
+	LoadedChunk result;
+	while (chunkResults.TryPop(result));
+	while (wakeStreaming.try_acquire());
+}
+
+void Tilemap::clearMap()
+{
+	stopStreamingThread();
+	streaming = false;
+
+	mapLayers.clear();
+	streamLayers.clear();
+	zLayers.clear();
+	allTextures.clear();
+	collisionLayer.clear();
+	tilesetRanges.clear();
+	collisionChunks.clear();
+	loadedChunks.clear();
+	pendingChunks.clear();
+	manifest = engine::MapManifest();
+}
+
+void Tilemap::initShader()
 {
 	m_shader->use();
 
 	//we'll make sure the current tile texture is active in 0, 
 	//and lookup texture is active in 1 in MapLayer::draw()
-	glUniform1i(glGetUniformLocation(m_shader->ID, "u_tileMap"), 0);
-	glUniform1i(glGetUniformLocation(m_shader->ID, "u_lookupMap"), 1);
+	m_shader->SetInt("u_tileMap", 0);
+	m_shader->SetInt("u_lookupMap", 1);
 
+	engine::RenderState::Get()->Enable(GL_BLEND);
+	engine::RenderState::Get()->BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glBlendEquation(GL_FUNC_ADD);
+}
+
+//Runs on the streaming thread: reads requested chunk files and builds their lookups, everything but the OpenGL work
+void Tilemap::streamChunks()
+{
+	while (true)
+	{
+		wakeStreaming.acquire();
+		if (stopStreaming)
+			return;
+
+		ChunkRequest request;
+		if (!chunkRequests.TryPop(request))
+			continue;
+
+		LoadedChunk result;
+		result.key = request.key;
+		result.x = request.x;
+		result.y = request.y;
+
+		//The chunk has to be the one asked for and the size the manifest says, so its tiles line up with the map
+		const auto chunkSize = manifest.chunkSize;
+		engine::MapChunkFile file;
+		if (file.Read(engine::MapManifest::ChunkPath(manifestPath, request.x, request.y)) && file.layers.size() == manifest.layers.size()
+			&& file.x == (std::uint32_t)request.x && file.y == (std::uint32_t)request.y
+			&& file.width == std::min(chunkSize, manifest.width - file.x * chunkSize) && file.height == std::min(chunkSize, manifest.height - file.y * chunkSize))
+		{
+			result.loaded = true;
+			result.width = file.width;
+			result.height = file.height;
+			for (auto i = 0u; i < manifest.layers.size(); ++i)
+			{
+				const auto& tiles = file.layers[i];
+				if (manifest.layers[i].collider)
+				{
+					result.collision.reserve(tiles.size());
+					for (const auto& tile : tiles)
+						result.collision.push_back(tile.ID);
+				}
+				else
+				{
+					result.lookups.push_back(MapLayer::buildLookups(tiles.data(), file.width, file.width, file.height, tilesetRanges));
+				}
+			}
+		}
+		else
+		{
+			std::cout << "Failed to read map chunk " << request.x << ", " << request.y << std::endl;
+		}
+
+		//Wait for the main thread to make room
+		while (!chunkResults.TryPush(std::move(result)))
+		{
+			if (stopStreaming)
+				return;
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+}
+
+void Tilemap::installChunk(LoadedChunk& chunk)
+{
+	const float chunkWidth = (float)manifest.chunkSize * manifest.tileWidth;
+	const float chunkHeight = (float)manifest.chunkSize * manifest.tileHeight;
+	const float left = bounds.left + chunk.x * chunkWidth;
+	const float top = bounds.top + chunk.y * chunkHeight;
+	const glm::vec4 rect(left, top, left + chunk.width * manifest.tileWidth, top + chunk.height * manifest.tileHeight);
+
+	for (auto i = 0u; i < streamLayers.size() && i < chunk.lookups.size(); ++i)
+		streamLayers[i]->addChunk(chunk.key, rect, chunk.width, chunk.height, chunk.lookups[i], tilesetRanges);
+
+	if (!chunk.collision.empty())
+		collisionChunks[chunk.key] = CollisionChunk{ chunk.width, std::move(chunk.collision) };
+	loadedChunks.insert(chunk.key);
+}
+
+void Tilemap::unloadChunk(std::uint64_t key)
+{
+	for (auto& layer : streamLayers)
+		layer->removeChunk(key);
+	collisionChunks.erase(key);
+	loadedChunks.erase(key);
+}
+
+void Tilemap::initGLStuff(const tmx::Map& map)
+{
+	initShader();
 
 	const auto& tilesets = map.getTilesets();
 	for (const auto& ts : tilesets)
@@ -173,10 +495,6 @@ void Tilemap::initGLStuff(const tmx::Map& map)
 		auto texture = loadTexture(ts.getImagePath());
 		allTextures.push_back(texture);
 	}
-
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glBlendEquation(GL_FUNC_ADD);
 }
 
 std::shared_ptr<engine::Texture> Tilemap::loadTexture(const std::string& path)
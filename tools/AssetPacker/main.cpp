@@ -0,0 +1,63 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include <engine/AssetPack.h>
+
+//Packs asset files into one asset pack the engine can mount
+//Usage: AssetPacker <output pack> <file or directory>...
+//Run it from the directory the game runs in, files are stored under the paths given, for example "assets/bullet.png"
+int main(int argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		std::cout << "Usage: AssetPacker <output pack> <file or directory>..." << std::endl;
+		return 1;
+	}
+	std::string output = argv[1];
+
+	//Directories are packed with everything in them
+	std::vector<std::string> files;
+	for (int i = 2; i < argc; i++)
+	{
+		std::filesystem::path input = argv[i];
+		if (std::filesystem::is_directory(input))
+		{
+			for (const auto& entry : std::filesystem::recursive_directory_iterator(input))
+				if (entry.is_regular_file())
+					files.push_back(entry.path().generic_string());
+		}
+		else if (std::filesystem::is_regular_file(input))
+		{
+			files.push_back(input.generic_string());
+		}
+		else
+		{
+			std::cout << "Error: " << argv[i] << " doesn't exist" << std::endl;
+			return 1;
+		}
+	}
+
+	//Don't pack the pack into itself
+	files.erase(std::remove_if(files.begin(), files.end(), [&](const std::string& file)
+		{
+			return engine::AssetPack::NormalizePath(file) == engine::AssetPack::NormalizePath(output);
+		}), files.end());
+
+	//Sorted so the same assets always make the same pack
+	std::sort(files.begin(), files.end());
+	files.erase(std::unique(files.begin(), files.end()), files.end());
+
+	if (!engine::AssetPack::Write(output, files))
+	{
+		std::cout << "Error writing " << output << std::endl;
+		return 1;
+	}
+
+	size_t bytes = 0;
+	for (const std::string& file : files)
+		bytes += std::filesystem::file_size(file);
+	std::cout << "Packed " << files.size() << " files, " << bytes << " bytes, into " << output << std::endl;
+	return 0;
+}
@@ -0,0 +1,135 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include <tmxlite/Map.hpp>
+#include <tmxlite/TileLayer.hpp>
+#include <engine/MapChunks.h>
+
+//Splits a Tiled map into chunk files a Tilemap can stream with loadStreamingMap
+//Usage: MapChunker <map.tmx> <output .tmap> [chunk size]
+//The chunk files are written next to the output manifest, named after it, for example "world_3_7.chunk"
+int main(int argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		std::cout << "Usage: MapChunker <map.tmx> <output .tmap> [chunk size]" << std::endl;
+		return 1;
+	}
+	std::string input = argv[1];
+	std::string output = argv[2];
+
+	tmx::Map map;
+	if (!map.load(input))
+	{
+		std::cout << "Error loading " << input << std::endl;
+		return 1;
+	}
+
+	engine::MapManifest manifest;
+	manifest.width = map.getTileCount().x;
+	manifest.height = map.getTileCount().y;
+	manifest.tileWidth = map.getTileSize().x;
+	manifest.tileHeight = map.getTileSize().y;
+	manifest.left = map.getBounds().left;
+	manifest.top = map.getBounds().top;
+	if (argc > 3)
+		manifest.chunkSize = std::max(1, std::stoi(argv[3]));
+
+	//Tileset images are found relative to the manifest, so the map can be moved with its images
+	std::filesystem::path outputDirectory = std::filesystem::absolute(output).parent_path();
+	for (const auto& ts : map.getTilesets())
+	{
+		engine::MapManifest::Tileset tileset;
+		tileset.firstGID = ts.getFirstGID();
+		tileset.tileCount = ts.getTileCount();
+		tileset.columns = ts.getColumnCount();
+		tileset.tileWidth = ts.getTileSize().x;
+		tileset.tileHeight = ts.getTileSize().y;
+		tileset.imagePath = std::filesystem::absolute(ts.getImagePath()).lexically_relative(outputDirectory).generic_string();
+		manifest.tilesets.push_back(tileset);
+	}
+
+	//Only tile layers are kept, with the same Z property and "collider" name loadMap uses
+	std::vector<const tmx::TileLayer*> tileLayers;
+	for (const auto& layer : map.getLayers())
+	{
+		if (layer->getType() != tmx::Layer::Type::Tile)
+			continue;
+
+		const auto& tileLayer = layer->getLayerAs<tmx::TileLayer>();
+		if (tileLayer.getTiles().size() < (size_t)manifest.width * manifest.height)
+		{
+			std::cout << "Skipping layer " << layer->getName() << ", it has fewer tiles than the map" << std::endl;
+			continue;
+		}
+
+		engine::MapManifest::Layer info;
+		info.name = layer->getName();
+		info.collider = info.name == "collider";
+		for (const auto& property : layer->getProperties())
+		{
+			if (property.getName() == "Z")
+			{
+				info.z = property.getFloatValue();
+				break;
+			}
+		}
+		manifest.layers.push_back(info);
+		tileLayers.push_back(&tileLayer);
+	}
+
+	manifest.chunks.assign((size_t)manifest.ChunksWide() * manifest.ChunksHigh(), 0);
+	size_t written = 0;
+	for (uint32_t chunkY = 0; chunkY < manifest.ChunksHigh(); chunkY++)
+	{
+		for (uint32_t chunkX = 0; chunkX < manifest.ChunksWide(); chunkX++)
+		{
+			engine::MapChunkFile chunk;
+			chunk.x = chunkX;
+			chunk.y = chunkY;
+			//Chunks on the right and bottom edges are cut to the map
+			chunk.width = std::min(manifest.chunkSize, manifest.width - chunkX * manifest.chunkSize);
+			chunk.height = std::min(manifest.chunkSize, manifest.height - chunkY * manifest.chunkSize);
+
+			bool empty = true;
+			for (const tmx::TileLayer* layer : tileLayers)
+			{
+				const auto& tiles = layer->getTiles();
+				chunk.layers.emplace_back();
+				for (uint32_t y = 0; y < chunk.height; y++)
+				{
+					for (uint32_t x = 0; x < chunk.width; x++)
+					{
+						const auto& tile = tiles[(size_t)(chunkY * manifest.chunkSize + y) * manifest.width + chunkX * manifest.chunkSize + x];
+						chunk.layers.back().push_back(tile);
+						empty = empty && tile.ID == 0;
+					}
+				}
+			}
+
+			//Chunks without any tiles don't get a file
+			if (empty)
+				continue;
+
+			std::string path = engine::MapManifest::ChunkPath(output, chunkX, chunkY);
+			if (!chunk.Write(path))
+			{
+				std::cout << "Error writing " << path << std::endl;
+				return 1;
+			}
+			manifest.chunks[(size_t)chunkY * manifest.ChunksWide() + chunkX] = 1;
+			written++;
+		}
+	}
+
+	if (!manifest.Write(output))
+	{
+		std::cout << "Error writing " << output << std::endl;
+		return 1;
+	}
+
+	std::cout << "Split " << input << " into " << written << " of " << manifest.chunks.size() << " chunks, manifest " << output << std::endl;
+	return 0;
+}
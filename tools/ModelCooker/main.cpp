@@ -0,0 +1,47 @@
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <engine/Model.h>
+
+//Converts models into the engine's cooked format, which loads without Assimp
+//Usage: ModelCooker [--pack-normals] <input model> <output file>
+//Keep the output next to the input, texture paths in the cooked file are relative to it
+int main(int argc, char* argv[])
+{
+	engine::MeshOptimizer::Options options;
+	int argument = 1;
+	if (argc == 4 && std::strcmp(argv[1], "--pack-normals") == 0)
+	{
+		options.packNormals = true;
+		argument++;
+	}
+
+	if (argc - argument != 2)
+	{
+		std::cout << "Usage: ModelCooker [--pack-normals] <input model> <output file>" << std::endl;
+		return 1;
+	}
+	const char* input = argv[argument];
+	const char* output = argv[argument + 1];
+
+	engine::ModelData model;
+	engine::MeshOptimizer::Report report;
+	if (!engine::Model::Import(input, model, options, &report))
+		return 1;
+
+	if (!engine::CookedModel::Write(model, output))
+	{
+		std::cout << "Error writing " << output << std::endl;
+		return 1;
+	}
+
+	size_t indexCount = 0;
+	for (const engine::MeshData& mesh : model.meshes)
+		indexCount += mesh.indices.size();
+	std::cout << "Cooked " << input << " into " << output << ": " << model.meshes.size() << " meshes, "
+		<< report.verticesAfter << " vertices, " << indexCount << " indices" << std::endl;
+	std::cout << "Vertices welded from " << report.verticesBefore << " to " << report.verticesAfter
+		<< ", cache misses per triangle from " << report.acmrBefore << " to " << report.acmrAfter << std::endl;
+	std::cout << "GPU memory from " << report.bytesBefore << " to " << report.bytesAfter << " bytes, " << report.BytesSaved() << " bytes saved" << std::endl;
+	return 0;
+}